@@ -5,6 +5,10 @@
 #include <klib.h>
 #include "debug.h"
 
+/* Uncomment these macros to enable corresponding functionality. */
+#define HAS_ASYE
+//#define HAS_PTE
+
 typedef char bool;
 #define true 1
 #define false 0
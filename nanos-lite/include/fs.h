@@ -5,11 +5,29 @@
 
 enum {SEEK_SET, SEEK_CUR, SEEK_END}; 
 
+#define NR_OPEN  16   // file descriptors per process
+#define NR_OFILE 64   // open files in the system
+
+typedef struct {
+  int file;       // index of the file table
+  off_t offset;
+  int ref;        // number of file descriptors referring to it
+} OpenFile;
+
+void init_fd_table(OpenFile **fds);
+void close_fd_table(OpenFile **fds);
+
 size_t fs_filesz(int fd);
+ssize_t fs_stat(int fd);
 int fs_open(const char* filename, int flags, int mode);
 ssize_t fs_read(int fd, void *buf, size_t len);
-ssize_t fs_write(int fd, void *buf, size_t len);
+ssize_t fs_write(int fd, const void *buf, size_t len);
+ssize_t fs_pread(int fd, void *buf, size_t len, off_t offset);
+ssize_t fs_pwrite(int fd, const void *buf, size_t len, off_t offset);
 int fs_close(int fd);
 off_t fs_lseek(int fd, off_t offset, int whence);
+void* fs_mmap(int fd, off_t offset, size_t len, bool writable);
+off_t fs_disk_offset(int fd);
+void fs_storage_read(void *buf, off_t offset, size_t len);
 
 #endif
\ No newline at end of file
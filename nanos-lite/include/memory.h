@@ -13,6 +13,21 @@
 #define PGROUNDUP(sz)   (((sz)+PGSIZE-1) & ~PGMASK)
 #define PGROUNDDOWN(a)  (((a)) & ~PGMASK)
 
+/* mmap() places mappings from here upwards in the user address space */
+#define MMAP_START 0x40000000
+// the same as PROT_READ and PROT_WRITE in <sys/mman.h> of Navy-apps
+#define PROT_READ 0x1
+#define PROT_WRITE 0x2
+
 void* new_page(void);
+void free_page(void *p);
+void* new_pages(int nr);
+void free_pages(void *p, int nr);
+uintptr_t mm_mmap(const void *addr, size_t len);
+uintptr_t mm_mmap_file(off_t offset, size_t len);
+int mm_munmap(uintptr_t va, size_t len);
+bool mm_fault(uintptr_t va);
+int mm_brk(uint32_t new_brk);
+void mm_release(void);
 
 #endif
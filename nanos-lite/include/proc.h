@@ -3,20 +3,51 @@
 
 #include "common.h"
 #include "memory.h"
+#include "fs.h"
 
 #define STACK_SIZE (8 * PGSIZE)
+#define NR_SEGMENT 8
+
+/* a PT_LOAD segment, or a mapping of a file by mmap(), which is loaded
+ * on demand */
+typedef struct {
+  uintptr_t vaddr;
+  size_t filesz, memsz;
+  off_t offset;   // where the contents are, read by fs_storage_read()
+} Segment;
 
 typedef union {
   uint8_t stack[STACK_SIZE] PG_ALIGN;
   struct {
     _RegSet *tf;
     _Protect as;
+    // the heap is [brk_start, cur_brk), and the pages below `max_brk' are mapped
+    uintptr_t brk_start;
     uintptr_t cur_brk;
-    // we do not free memory, so use `max_brk' to determine when to call _map()
     uintptr_t max_brk;
+    // where the next mmap() region starts, it only grows
+    uintptr_t mmap_brk;
+    Segment seg[NR_SEGMENT];
+    int nr_seg;
+    OpenFile *fd_table[NR_OPEN];
+    int priority;         // time slices to run in a row
+    int slice;            // time slices left
+    uint32_t runtime;     // CPU time in milliseconds
+    uint32_t nr_switch;   // times switched to
+    void *ring;           // the registered submission and completion rings
+    bool dead;            // exited, and never scheduled again
   };
 } PCB;
 
 extern PCB *current;
 
+void load_prog(const char *filename, int priority);
+_RegSet* schedule(_RegSet *prev);
+_RegSet* schedule_tick(_RegSet *prev);
+_RegSet* proc_exit(_RegSet *prev, int status);
+uint32_t proc_runtime(void);
+void ring_poll(void);
+
+uintptr_t loader(PCB *pcb, const char *filename);
+
 #endif
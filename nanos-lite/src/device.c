@@ -28,32 +28,118 @@ size_t events_read(void *buf, size_t len) {
   return 0;
 }
 
+/* The records of /dev/events_bin, the same as NDL_Event in Navy-apps.
+ * `data' is the key code of key events, or the uptime in milliseconds
+ * of timer events. */
+enum { EVENT_KEYDOWN, EVENT_KEYUP, EVENT_TIMER };
+
+typedef struct {
+  uint32_t type;
+  uint32_t data;
+} Event;
+
+/* Return as many queued key events as fit in `buf'. A timer event is
+ * returned instead when no key is pressed or released. */
+size_t events_bin_read(void *buf, size_t len) {
+  Event *ev = buf;
+  int n = len / sizeof(Event);
+  int i = 0;
+  while (i < n) {
+    int key = _read_key();
+    if (key == _KEY_NONE) {
+      break;
+    }
+    ev[i].type = (key & 0x8000 ? EVENT_KEYDOWN : EVENT_KEYUP);
+    ev[i].data = key & ~0x8000;
+    i ++;
+  }
+
+  if (i == 0 && n > 0) {
+    ev[0].type = EVENT_TIMER;
+    ev[0].data = _uptime();
+    i = 1;
+  }
+  return i * sizeof(Event);
+}
+
 static char dispinfo[128] __attribute__((used));
 
 void dispinfo_read(void *buf, off_t offset, size_t len) {
   strncpy(buf, dispinfo+offset, len);
 }
 
+// The pixels are split into at most three rectangles (the rest of the
+// first row, whole rows, and the head of the last row), which are drawn
+// by the blitter in one batch.
 void fb_write(const void *buf, off_t offset, size_t len) {
-  int screen_y1 = offset / 4 / _screen.width;
-  int screen_x1 = offset / 4 % _screen.width;
-  int screen_y2 = (offset+len) / 4 / _screen.width;
-  if(screen_y2 == screen_y1){  
-    _draw_rect(buf, screen_x1, screen_y1, len/4, 1);
-    return;
+  const uint32_t *pixels = buf;
+  int x = offset / 4 % _screen.width;
+  int y = offset / 4 / _screen.width;
+  int n = len / 4;
+  _Blit ops[3];
+  int nr_op = 0;
+
+  if (x != 0 && n > 0) {
+    int w = (n < _screen.width - x ? n : _screen.width - x);
+    ops[nr_op ++] = (_Blit) { .op = _BLIT_COPY, .x = x, .y = y, .w = w, .h = 1, .src = pixels, .pitch = w };
+    pixels += w;
+    n -= w;
+    y ++;
   }
 
-  int tempw = _screen.width - screen_x1;
-  if(screen_y2 - screen_y1 == 1) {
-    _draw_rect(buf, screen_x1, screen_y1, tempw, 1);
-    _draw_rect(buf+tempw*4, 0, screen_y2, len/4-tempw, 1);
-    return;
+  int rows = n / _screen.width;
+  if (rows > 0) {
+    ops[nr_op ++] = (_Blit) { .op = _BLIT_COPY, .x = 0, .y = y, .w = _screen.width, .h = rows,
+      .src = pixels, .pitch = _screen.width };
+    pixels += rows * _screen.width;
+    n -= rows * _screen.width;
+    y += rows;
   }
-  
-  _draw_rect(buf, screen_x1, screen_y1, tempw, 1);
-  int tempy = screen_y2 - screen_y1 - 1;
-  _draw_rect(buf+tempw*4, 0, screen_y1+1, _screen.width, tempy);
-  _draw_rect(buf+tempw*4+tempy*_screen.width*4, 0, screen_y2, len/4-tempw-tempy*_screen.width, 1);
+
+  if (n > 0) {
+    ops[nr_op ++] = (_Blit) { .op = _BLIT_COPY, .x = 0, .y = y, .w = n, .h = 1, .src = pixels, .pitch = n };
+  }
+
+  _blit(ops, nr_op);
+}
+
+/* A write to /dev/fbctl is an array of these. Every rectangle is drawn
+ * from `pixels' with `stride' pixels per row, and all of them are drawn in
+ * one batch of the blitter. The screen is synchronized after that. */
+typedef struct {
+  int32_t x, y, w, h;
+  int32_t stride;
+  const uint32_t *pixels;
+} FbRect;
+
+#define NR_FBCTL_BATCH 16
+
+size_t fbctl_write(const void *buf, size_t len) {
+  const FbRect *r = buf;
+  int n = len / sizeof(FbRect);
+  _Blit ops[NR_FBCTL_BATCH];
+
+  for (int i = 0; i < n; i += NR_FBCTL_BATCH) {
+    int nr_op = (n - i < NR_FBCTL_BATCH ? n - i : NR_FBCTL_BATCH);
+    for (int j = 0; j < nr_op; j ++) {
+      const FbRect *p = &r[i + j];
+      ops[j] = (_Blit) { .op = _BLIT_COPY, .x = p->x, .y = p->y, .w = p->w, .h = p->h,
+        .src = p->pixels, .pitch = p->stride };
+    }
+    _blit(ops, nr_op);
+  }
+
+  // a write without rectangles only flushes what is drawn through
+  // the mapping of /dev/fb
+  _draw_sync();
+  return n * sizeof(FbRect);
+}
+
+/* /proc/perfcnt is the _PerfCnt of the CPU, read at the time of the read */
+void perfcnt_read(void *buf, off_t offset, size_t len) {
+  _PerfCnt cnt;
+  _perf_read(&cnt);
+  memcpy(buf, (uint8_t *)&cnt + offset, len);
 }
 
 void init_device() {
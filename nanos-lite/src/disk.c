@@ -0,0 +1,130 @@
+#include "common.h"
+
+/* If NEMU is given a disk, the files are read from it instead of ramdisk.
+ * Blocks of the disk are cached and replaced in LRU order. A miss also
+ * reads the following blocks ahead, since files are mostly read in order.
+ * Writes go through to the disk at once.
+ */
+
+#define BLOCK_SIZE 4096
+#define SECTORS_PER_BLOCK (BLOCK_SIZE / _DISK_SECTOR_SIZE)
+#define NR_BUF 64
+#define NR_READ_AHEAD 4
+
+typedef struct Buf {
+  uint32_t block;
+  bool valid;
+  struct Buf *prev, *next;
+  uint8_t data[BLOCK_SIZE];
+} Buf;
+
+static Buf bufs[NR_BUF];
+// the head of the LRU list, the most recently used buffer is the first
+static Buf lru;
+static uint32_t nr_sector;
+
+static void lru_remove(Buf *b) {
+  b->prev->next = b->next;
+  b->next->prev = b->prev;
+}
+
+static void lru_push_front(Buf *b) {
+  b->next = lru.next;
+  b->prev = &lru;
+  lru.next->prev = b;
+  lru.next = b;
+}
+
+static Buf* lookup(uint32_t block) {
+  for (Buf *b = lru.next; b != &lru; b = b->next) {
+    if (b->valid && b->block == block) {
+      return b;
+    }
+  }
+  return NULL;
+}
+
+/* Read `block' into the least recently used buffer, which becomes the
+ * most recently used one. */
+static Buf* fill(uint32_t block) {
+  Buf *b = lru.prev;
+  uint32_t sector = block * SECTORS_PER_BLOCK;
+  int n = (nr_sector - sector < SECTORS_PER_BLOCK ? nr_sector - sector : SECTORS_PER_BLOCK);
+  b->valid = (_disk_read(b->data, sector, n) == 0);
+  assert(b->valid);
+  b->block = block;
+  lru_remove(b);
+  lru_push_front(b);
+  return b;
+}
+
+static Buf* get_block(uint32_t block) {
+  Buf *b = lookup(block);
+  if (b != NULL) {
+    lru_remove(b);
+    lru_push_front(b);
+    return b;
+  }
+
+  uint32_t nr_block = (nr_sector + SECTORS_PER_BLOCK - 1) / SECTORS_PER_BLOCK;
+  for (uint32_t i = 1; i <= NR_READ_AHEAD && block + i < nr_block; i ++) {
+    if (lookup(block + i) == NULL) {
+      fill(block + i);
+    }
+  }
+  return fill(block);
+}
+
+bool disk_present() {
+  return nr_sector > 0;
+}
+
+/* read `len' bytes starting from `offset' of the disk into `buf' */
+void disk_read(void *buf, off_t offset, size_t len) {
+  assert(offset + len <= (size_t)nr_sector * _DISK_SECTOR_SIZE);
+  while (len > 0) {
+    Buf *b = get_block(offset / BLOCK_SIZE);
+    size_t off = offset % BLOCK_SIZE;
+    size_t n = (len < BLOCK_SIZE - off ? len : BLOCK_SIZE - off);
+    memcpy(buf, b->data + off, n);
+    buf = (uint8_t *)buf + n;
+    offset += n;
+    len -= n;
+  }
+}
+
+/* write `len' bytes starting from `buf' into the `offset' of the disk */
+void disk_write(const void *buf, off_t offset, size_t len) {
+  assert(offset + len <= (size_t)nr_sector * _DISK_SECTOR_SIZE);
+  while (len > 0) {
+    Buf *b = get_block(offset / BLOCK_SIZE);
+    size_t off = offset % BLOCK_SIZE;
+    size_t n = (len < BLOCK_SIZE - off ? len : BLOCK_SIZE - off);
+    memcpy(b->data + off, buf, n);
+
+    // only the sectors touched are written back
+    int first = off / _DISK_SECTOR_SIZE;
+    int last = (off + n - 1) / _DISK_SECTOR_SIZE;
+    int ret = _disk_write(b->data + first * _DISK_SECTOR_SIZE,
+        b->block * SECTORS_PER_BLOCK + first, last - first + 1);
+    assert(ret == 0);
+
+    buf = (const uint8_t *)buf + n;
+    offset += n;
+    len -= n;
+  }
+}
+
+void init_disk() {
+  nr_sector = _disk_size();
+  if (nr_sector == 0) {
+    return;
+  }
+
+  lru.prev = lru.next = &lru;
+  for (int i = 0; i < NR_BUF; i ++) {
+    bufs[i].valid = false;
+    lru_push_front(&bufs[i]);
+  }
+  Log("disk info: %d sectors, %d buffers of %d bytes", nr_sector, NR_BUF, BLOCK_SIZE);
+}
@@ -1,13 +1,15 @@
 #include "fs.h"
+#include "proc.h"
 
 typedef struct {
   char *name;
   size_t size;
   off_t disk_offset;
-  off_t open_offset;
 } Finfo;
 
-enum {FD_STDIN, FD_STDOUT, FD_STDERR, FD_FB, FD_EVENTS, FD_DISPINFO, FD_NORMAL};
+/* These are indices of `file_table'. The standard streams are also
+ * the first three file descriptors of every process. */
+enum {FD_STDIN, FD_STDOUT, FD_STDERR, FD_FB, FD_FBCTL, FD_EVENTS, FD_EVENTS_BIN, FD_DISPINFO, FD_MEMINFO, FD_PERFCNT, FD_NORMAL};
 
 /* This is the information about all files in disk. */
 static Finfo file_table[] __attribute__((used)) = {
@@ -15,129 +17,337 @@ static Finfo file_table[] __attribute__((used)) = {
   {"stdout (note that this is not the actual stdout)", 0, 0},
   {"stderr (note that this is not the actual stderr)", 0, 0},
   [FD_FB] = {"/dev/fb", 0, 0},
+  [FD_FBCTL] = {"/dev/fbctl", 0, 0},
   [FD_EVENTS] = {"/dev/events", 0, 0},
+  [FD_EVENTS_BIN] = {"/dev/events_bin", 0, 0},
   [FD_DISPINFO] = {"/proc/dispinfo", 128, 0},
+  [FD_MEMINFO] = {"/proc/meminfo", 128, 0},
+  [FD_PERFCNT] = {"/proc/perfcnt", sizeof(_PerfCnt), 0},
 #include "files.h"
 };
 
 #define NR_FILES (sizeof(file_table) / sizeof(file_table[0]))
 
-void init_fs() {
-  // TODO: initialize the size of /dev/fb
+/* `file_slot' is a hash table generated together with files.h. Every slot
+ * holds the index of a file after FD_NORMAL, or -1 if it is empty. */
+#include "files-index.h"
 
-  file_table[FD_FB].size = _screen.height * _screen.width * 4;
-  Log("set FD_FB size = %d", file_table[FD_FB].size);
+/* The same hash function is used by the generator in Makefile. */
+static uint32_t file_hash(const char *name) {
+  uint32_t h = 0;
+  for (const unsigned char *p = (const unsigned char *)name; *p; p ++) {
+    h = (h * 31 + *p) % NR_FILE_SLOT;
+  }
+  return h;
+}
+
+static int file_lookup(const char *name) {
+  for (int i = 0; i < FD_NORMAL; i ++) {
+    if (strcmp(name, file_table[i].name) == 0) {
+      return i;
+    }
+  }
+
+  for (uint32_t h = file_hash(name); file_slot[h] != -1; h = (h + 1) % NR_FILE_SLOT) {
+    int i = FD_NORMAL + file_slot[h];
+    if (strcmp(name, file_table[i].name) == 0) {
+      return i;
+    }
+  }
+  return -1;
 }
 
+/* Open files are shared by all descriptors referring to them,
+ * and each of them keeps its own offset. */
+static OpenFile open_files[NR_OFILE];
 
+/* file descriptors used before the first process is loaded */
+static OpenFile *boot_fd_table[NR_OPEN];
 
-size_t fs_fliesz(int fd) {
-  return file_table[fd].size;
+static OpenFile **fd_table() {
+  return (current == NULL ? boot_fd_table : current->fd_table);
 }
 
-off_t disk_offset(int fd){
-	assert(fd >= 0 && fd < NR_FILES);
-	return file_table[fd].disk_offset;
+static OpenFile* get_file(int fd) {
+  if (fd < 0 || fd >= NR_OPEN) {
+    return NULL;
+  }
+  return fd_table()[fd];
 }
 
-off_t get_open_offset(int fd){
-	assert(fd >= 0 && fd < NR_FILES);
-	return file_table[fd].open_offset;
+static OpenFile* alloc_file(int file) {
+  for (int i = 0; i < NR_OFILE; i ++) {
+    if (open_files[i].ref == 0) {
+      open_files[i].file = file;
+      open_files[i].offset = 0;
+      open_files[i].ref = 1;
+      return &open_files[i];
+    }
+  }
+  return NULL;
 }
 
-void set_open_offset(int fd,off_t n){
-	assert(fd >= 0 && fd < NR_FILES);
-	assert(n >= 0);
-	if(n > file_table[fd].size) {
-		n = file_table[fd].size;
-	}
-	file_table[fd].open_offset = n;
+/* the standard streams are shared by all processes */
+void init_fd_table(OpenFile **fds) {
+  for (int fd = FD_STDIN; fd <= FD_STDERR; fd ++) {
+    fds[fd] = boot_fd_table[fd];
+    fds[fd]->ref ++;
+  }
+}
+
+/* close all file descriptors of an exiting process */
+void close_fd_table(OpenFile **fds) {
+  for (int fd = 0; fd < NR_OPEN; fd ++) {
+    if (fds[fd] != NULL) {
+      fds[fd]->ref --;
+      fds[fd] = NULL;
+    }
+  }
+}
+
+void init_fs() {
+  // TODO: initialize the size of /dev/fb
+
+  file_table[FD_FB].size = _screen.height * _screen.width * 4;
+  Log("set FD_FB size = %d", file_table[FD_FB].size);
+
+  for (int fd = FD_STDIN; fd <= FD_STDERR; fd ++) {
+    boot_fd_table[fd] = alloc_file(fd);
+  }
 }
 
 extern void ramdisk_read(void *buf, off_t offset, size_t len);
 extern void ramdisk_write(const void *buf, off_t offset, size_t len);
+extern void* ramdisk_map(off_t offset, size_t len);
+extern bool disk_present();
+extern void disk_read(void *buf, off_t offset, size_t len);
+extern void disk_write(const void *buf, off_t offset, size_t len);
+
+/* The contents of files are on the disk if there is one, or in ramdisk. */
+void fs_storage_read(void *buf, off_t offset, size_t len) {
+  if (disk_present()) {
+    disk_read(buf, offset, len);
+  }
+  else {
+    ramdisk_read(buf, offset, len);
+  }
+}
+
+static void fs_storage_write(const void *buf, off_t offset, size_t len) {
+  if (disk_present()) {
+    disk_write(buf, offset, len);
+  }
+  else {
+    ramdisk_write(buf, offset, len);
+  }
+}
 
 int fs_open(const char*filename, int flags, int mode) {
-	for(int i = 0; i < NR_FILES; i++){
-		if(strcmp(filename, file_table[i].name) == 0) {
-			Log("success open:%d:%s",i,filename);
-			return i;
+	int file = file_lookup(filename);
+	if (file < 0) {
+		Log("no such file: %s", filename);
+		return -1;
+	}
+
+	OpenFile **fds = fd_table();
+	for (int fd = 0; fd < NR_OPEN; fd ++) {
+		if (fds[fd] == NULL) {
+			fds[fd] = alloc_file(file);
+			if (fds[fd] == NULL) {
+				Log("too many open files");
+				return -1;
+			}
+			Log("success open:%d:%s", fd, filename);
+			return fd;
 		}
 	}
-	panic("this file not exist");
+	Log("too many open files in the process");
 	return -1;
 }
 
+/* Read and write at `offset' of a file, and return the number of bytes
+ * transferred. Devices without a size ignore the offset. */
 
 extern void fb_write(const void *buf, off_t offset, size_t len);
-ssize_t fs_write(int fd, void *buf, size_t len){
-  assert(fd >= 0 && fd < NR_FILES);
-  if(fd < 3 || fd == FD_DISPINFO) {
-    Log("arg invalid:fd<3");
-    return 0;
-  }
-  int n = fs_fliesz(fd) - get_open_offset(fd);
-  if(n > len) {
+extern size_t fbctl_write(const void *buf, size_t len);
+static ssize_t file_write(int file, const void *buf, off_t offset, size_t len) {
+  if (file == FD_STDOUT || file == FD_STDERR) {
+    _puts(buf, len);
+    return len;
+  }
+  if (file == FD_FBCTL) {
+    return fbctl_write(buf, len);
+  }
+  if (file == FD_STDIN || file == FD_EVENTS || file == FD_EVENTS_BIN ||
+      file == FD_DISPINFO || file == FD_MEMINFO || file == FD_PERFCNT) {
+    return -1;
+  }
+
+  int n = (offset < file_table[file].size ? file_table[file].size - offset : 0);
+  if (n > len) {
     n = len;
   }
-  if(fd == FD_FB){
-    fb_write(buf, get_open_offset(fd), n);
+  if (file == FD_FB) {
+    fb_write(buf, offset, n);
   }
   else {
-    ramdisk_write(buf, disk_offset(fd) + get_open_offset(fd), n);
+    fs_storage_write(buf, file_table[file].disk_offset + offset, n);
   }
-  set_open_offset(fd, get_open_offset(fd) + n);
   return n;
 }
 
 void dispinfo_read(void *buf, off_t offset, size_t len);
+void meminfo_read(void *buf, off_t offset, size_t len);
+void perfcnt_read(void *buf, off_t offset, size_t len);
 extern size_t events_read(void *buf, size_t len);
-ssize_t fs_read(int fd, void *buf, size_t len){
-  assert(fd >= 0 && fd < NR_FILES);
-  if(fd < 3 || fd == FD_FB) {
-    Log("arg invalid:fd<3");
-    return 0;
-  }
-  if(fd == FD_EVENTS) {
+extern size_t events_bin_read(void *buf, size_t len);
+static ssize_t file_read(int file, void *buf, off_t offset, size_t len) {
+  if (file == FD_EVENTS) {
     return events_read(buf, len);
   }
-  int n = fs_fliesz(fd) - get_open_offset(fd);
-  if(n > len) {
+  if (file == FD_EVENTS_BIN) {
+    return events_bin_read(buf, len);
+  }
+  if (file <= FD_STDERR || file == FD_FB || file == FD_FBCTL) {
+    return -1;
+  }
+
+  int n = (offset < file_table[file].size ? file_table[file].size - offset : 0);
+  if (n > len) {
     n = len;
   }
-  if(fd == FD_DISPINFO){
-    dispinfo_read(buf, get_open_offset(fd), n);
+  if (file == FD_DISPINFO) {
+    dispinfo_read(buf, offset, n);
+  }
+  else if (file == FD_MEMINFO) {
+    meminfo_read(buf, offset, n);
+  }
+  else if (file == FD_PERFCNT) {
+    perfcnt_read(buf, offset, n);
   }
   else {
-    ramdisk_read(buf, disk_offset(fd) + get_open_offset(fd), n);
+    fs_storage_read(buf, file_table[file].disk_offset + offset, n);
+  }
+  return n;
+}
+
+ssize_t fs_write(int fd, const void *buf, size_t len) {
+  OpenFile *of = get_file(fd);
+  if (of == NULL) {
+    return -1;
+  }
+  ssize_t n = file_write(of->file, buf, of->offset, len);
+  if (n > 0) {
+    of->offset += n;
+  }
+  return n;
+}
+
+ssize_t fs_read(int fd, void *buf, size_t len) {
+  OpenFile *of = get_file(fd);
+  if (of == NULL) {
+    return -1;
+  }
+  ssize_t n = file_read(of->file, buf, of->offset, len);
+  if (n > 0) {
+    of->offset += n;
   }
-  set_open_offset(fd, get_open_offset(fd) + n);
   return n;
 }
 
+ssize_t fs_pwrite(int fd, const void *buf, size_t len, off_t offset) {
+  OpenFile *of = get_file(fd);
+  if (of == NULL || offset < 0) {
+    return -1;
+  }
+  return file_write(of->file, buf, offset, len);
+}
+
+ssize_t fs_pread(int fd, void *buf, size_t len, off_t offset) {
+  OpenFile *of = get_file(fd);
+  if (of == NULL || offset < 0) {
+    return -1;
+  }
+  return file_read(of->file, buf, offset, len);
+}
+
 int fs_close(int fd) {
-  assert(fd >= 0 && fd < NR_FILES);
+  OpenFile *of = get_file(fd);
+  if (of == NULL) {
+    return -1;
+  }
+  of->ref --;
+  fd_table()[fd] = NULL;
   return 0;
 }
 
 size_t fs_filesz(int fd) {
-  assert(fd >= 0 && fd < NR_FILES);
-  return file_table[fd].size;
+  OpenFile *of = get_file(fd);
+  assert(of != NULL);
+  return file_table[of->file].size;
+}
+
+ssize_t fs_stat(int fd) {
+  OpenFile *of = get_file(fd);
+  if (of == NULL) {
+    return -1;
+  }
+  return file_table[of->file].size;
 }
 
 off_t fs_lseek(int fd, off_t offset, int whence) {
+  OpenFile *of = get_file(fd);
+  if (of == NULL) {
+    return -1;
+  }
+
+  off_t size = file_table[of->file].size;
   switch(whence) {
-    case SEEK_SET:
-      set_open_offset(fd, offset);
-      return get_open_offset(fd);
-    case SEEK_CUR:
-      set_open_offset(fd, get_open_offset(fd) + offset);
-      return get_open_offset(fd);
-    case SEEK_END:
-      set_open_offset(fd, fs_filesz(fd) + offset);
-      return get_open_offset(fd);
+    case SEEK_SET: break;
+    case SEEK_CUR: offset += of->offset; break;
+    case SEEK_END: offset += size; break;
     default:
-      panic("Unhandled whence ID = %d", whence);
+      Log("Unhandled whence ID = %d", whence);
       return -1;
-    }
-}
\ No newline at end of file
+  }
+  if (offset < 0) {
+    return -1;
+  }
+  of->offset = (offset > size ? size : offset);
+  return of->offset;
+}
+
+/* Return the address of [offset, offset + len) of a file in ramdisk or of
+ * /dev/fb, or NULL if the file can not be mapped in place or the range is
+ * out of the file. Files in ramdisk are read-only, and files which are
+ * compressed or on the disk are not in memory. */
+void* fs_mmap(int fd, off_t offset, size_t len, bool writable) {
+  OpenFile *of = get_file(fd);
+  if (of == NULL || (of->file < FD_NORMAL && of->file != FD_FB)) {
+    return NULL;
+  }
+
+  Finfo *f = &file_table[of->file];
+  if (len == 0 || offset < 0 || offset > f->size || len > f->size - offset) {
+    return NULL;
+  }
+
+  if (of->file == FD_FB) {
+    uint8_t *fb = (uint8_t *)_framebuffer();
+    return (fb == NULL ? NULL : fb + offset);
+  }
+  if (writable || disk_present()) {
+    return NULL;
+  }
+  return ramdisk_map(f->disk_offset + offset, len);
+}
+
+/* Return where the contents of a regular file start in the storage read
+ * by fs_storage_read(), or -1 if the file is a device. */
+off_t fs_disk_offset(int fd) {
+  OpenFile *of = get_file(fd);
+  if (of == NULL || of->file < FD_NORMAL) {
+    return -1;
+  }
+  return file_table[of->file].disk_offset;
+}
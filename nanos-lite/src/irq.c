@@ -1,10 +1,19 @@
-#include "common.h"
+#include "proc.h"
 
 extern _RegSet* do_syscall(_RegSet *r);
 static _RegSet* do_event(_Event e, _RegSet* r) {
   switch (e.event) {
     case _EVENT_SYSCALL:
       return do_syscall(r);
+    case _EVENT_IRQ_TIME:
+      return schedule_tick(r);
+    case _EVENT_TRAP:
+      return schedule(r);
+    case _EVENT_PAGE_FAULT:
+      if (!mm_fault(e.cause)) {
+        panic("Page fault at 0x%08x, eip = 0x%08x", e.cause, r->eip);
+      }
+      return NULL;
     default: panic("Unhandled event ID = %d", e.event);
   }
 
@@ -1,17 +1,54 @@
-#include "common.h"
-#include "fs.h"
+#include "proc.h"
+#include <elf.h>
 
-#define DEFAULT_ENTRY ((void *)0x4000000)
-
-extern uint8_t ramdisk_start;
-extern uint8_t ramdisk_end;
-#define RAMDISK_SIZE ((&ramdisk_end) - (&ramdisk_start))
-extern void ramdisk_read(void *buf, off_t offset, size_t len);
-
-uintptr_t loader(_Protect *as, const char *filename) {
+/* Load the program segments of the ELF file `filename' and return its
+ * entry. Without an address space, or without HAS_PTE, the segments are
+ * copied to their addresses at once. Otherwise they are only recorded in
+ * the PCB, and every page is filled by mm_fault() on the first touch. */
+uintptr_t loader(PCB *pcb, const char *filename) {
   int fd = fs_open(filename, 0, 0);
   Log("filename=%s, fd=%d", filename, fd);
-  fs_read(fd, DEFAULT_ENTRY, fs_filesz(fd));
+  if (fd < 0) {
+    panic("%s does not exist", filename);
+  }
+
+  Elf32_Ehdr eh;
+  if (fs_pread(fd, &eh, sizeof(eh), 0) != sizeof(eh) ||
+      *(uint32_t *)eh.e_ident != *(uint32_t *)ELFMAG || eh.e_machine != EM_386) {
+    panic("%s is not an ELF executable for x86", filename);
+  }
+
+  for (int i = 0; i < eh.e_phnum; i ++) {
+    Elf32_Phdr ph;
+    fs_pread(fd, &ph, sizeof(ph), eh.e_phoff + i * eh.e_phentsize);
+    if (ph.p_type != PT_LOAD || ph.p_memsz == 0) {
+      continue;
+    }
+
+#ifdef HAS_PTE
+    if (pcb != NULL) {
+      assert(pcb->nr_seg < NR_SEGMENT);
+      Segment *seg = &pcb->seg[pcb->nr_seg ++];
+      seg->vaddr = ph.p_vaddr;
+      seg->filesz = ph.p_filesz;
+      seg->memsz = ph.p_memsz;
+      // the contents stay in storage, even after the file is closed
+      seg->offset = fs_disk_offset(fd) + ph.p_offset;
+
+      // the heap starts right after the highest segment
+      if (ph.p_vaddr + ph.p_memsz > pcb->brk_start) {
+        pcb->brk_start = pcb->cur_brk = ph.p_vaddr + ph.p_memsz;
+        pcb->max_brk = PGROUNDUP(pcb->brk_start);
+      }
+      continue;
+    }
+#endif
+
+    fs_pread(fd, (void *)ph.p_vaddr, ph.p_filesz, ph.p_offset);
+    // .bss
+    memset((void *)(ph.p_vaddr + ph.p_filesz), 0, ph.p_memsz - ph.p_filesz);
+  }
+
   fs_close(fd);
-  return (uintptr_t)DEFAULT_ENTRY;
-}
\ No newline at end of file
+  return eh.e_entry;
+}
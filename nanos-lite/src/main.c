@@ -1,20 +1,14 @@
-#include "common.h"
-
-/* Uncomment these macros to enable corresponding functionality. */
-#define HAS_ASYE
-//#define HAS_PTE
+#include "proc.h"
 
 void init_mm(void);
 void init_ramdisk(void);
 void init_device(void);
 void init_irq(void);
 void init_fs(void);
-uint32_t loader(_Protect *, const char *);
+void init_disk(void);
 
 int main() {
-#ifdef HAS_PTE
   init_mm();
-#endif
 
   Log("'Hello World!' from Nanos-lite");
   Log("Build time: %s, %s", __TIME__, __DATE__);
@@ -23,6 +17,8 @@ int main() {
 
   init_device();
 
+  init_disk();
+
 #ifdef HAS_ASYE
   Log("Initializing interrupt/exception handler...");
   init_irq();
@@ -30,8 +26,18 @@ int main() {
 
   init_fs();
 
+#ifdef HAS_ASYE
+  load_prog("/bin/pal", 2);
+#ifdef HAS_PTE
+  // programs are linked at the same address, so they can only run
+  // together in their own address spaces
+  load_prog("/bin/hello", 1);
+#endif
+  _trap();
+#else
   uint32_t entry = loader(NULL, "/bin/pal");
   ((void (*)(void))entry)();
+#endif
 
   panic("Should not reach here");
 }
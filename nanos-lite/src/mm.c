@@ -1,27 +1,387 @@
 #include "proc.h"
 #include "memory.h"
 
-static void *pf = NULL;
+/* The physical pages from `_heap.start' to `_heap.end' are managed by a
+ * map of their states, which is placed at the beginning of the heap.
+ * Freed pages are kept in a doubly linked list threaded through the pages
+ * themselves, so that a single page is allocated and freed in O(1).
+ * Pages above `top' have never been allocated. They are used after the
+ * free list runs out, which keeps long runs for new_pages().
+ */
+
+enum { PAGE_FREE, PAGE_USED };
+
+typedef struct FreePage {
+  struct FreePage *prev, *next;
+} FreePage;
+
+static uint8_t *page_state = NULL;
+static void *pf = NULL;         // the first page managed
+static int nr_page = 0;
+static int top = 0;             // pages from `top' on have never been allocated
+static FreePage *free_list = NULL;
+
+static struct {
+  int nr_free;
+  int nr_used_max;
+  uint32_t nr_alloc, nr_release;
+} mstat;
+
+#define PAGE(i) (pf + (i) * PGSIZE)
+#define PAGE_IDX(p) (((void *)(p) - pf) / PGSIZE)
+
+static inline void list_remove(FreePage *p) {
+  if (p->prev) { p->prev->next = p->next; } else { free_list = p->next; }
+  if (p->next) { p->next->prev = p->prev; }
+}
+
+static inline void list_insert(FreePage *p) {
+  p->prev = NULL;
+  p->next = free_list;
+  if (free_list) { free_list->prev = p; }
+  free_list = p;
+}
+
+static void account_alloc(int nr) {
+  mstat.nr_free -= nr;
+  mstat.nr_alloc ++;
+  if (nr_page - mstat.nr_free > mstat.nr_used_max) {
+    mstat.nr_used_max = nr_page - mstat.nr_free;
+  }
+}
 
 void* new_page(void) {
-  assert(pf < (void *)_heap.end);
-  void *p = pf;
-  pf += PGSIZE;
-  return p;
+  int idx;
+  if (free_list != NULL) {
+    FreePage *p = free_list;
+    list_remove(p);
+    idx = PAGE_IDX(p);
+  }
+  else {
+    assert(top < nr_page);
+    idx = top ++;
+  }
+
+  page_state[idx] = PAGE_USED;
+  account_alloc(1);
+  return PAGE(idx);
+}
+
+/* Allocate `nr' physically contiguous pages, or return NULL. */
+void* new_pages(int nr) {
+  if (nr == 1) {
+    return new_page();
+  }
+
+  // look for the lowest run of free pages, which may extend to the pages above `top'
+  int start = 0, len = 0;
+  for (int i = 0; i < nr_page; i ++) {
+    if (i >= top) {
+      if (len == 0) { start = i; }
+      if (nr_page - start >= nr) { len = nr; }
+      break;
+    }
+    if (page_state[i] == PAGE_FREE) {
+      if (len ++ == 0) { start = i; }
+      if (len == nr) { break; }
+    }
+    else {
+      len = 0;
+    }
+  }
+  if (len < nr) {
+    return NULL;
+  }
+
+  for (int i = start; i < start + nr; i ++) {
+    if (i < top) { list_remove(PAGE(i)); }
+    page_state[i] = PAGE_USED;
+  }
+  if (start + nr > top) {
+    top = start + nr;
+  }
+
+  account_alloc(nr);
+  return PAGE(start);
+}
+
+void free_pages(void *p, int nr) {
+  assert(p >= pf && ((uintptr_t)p & PGMASK) == 0);
+  int idx = PAGE_IDX(p);
+  assert(idx + nr <= top);
+
+  for (int i = idx; i < idx + nr; i ++) {
+    assert(page_state[i] == PAGE_USED);
+    page_state[i] = PAGE_FREE;
+    list_insert(PAGE(i));
+  }
+  mstat.nr_free += nr;
+  mstat.nr_release ++;
 }
 
 void free_page(void *p) {
-  panic("not implement yet");
+  free_pages(p, 1);
 }
 
-/* The brk() system call handler. */
+/* /proc/meminfo */
+void meminfo_read(void *buf, off_t offset, size_t len) {
+  char info[128];
+  snprintf(info, sizeof(info),
+      "PageSize: %d\nTotal: %d\nFree: %d\nMaxUsed: %d\nAlloc: %u\nRelease: %u\n",
+      PGSIZE, nr_page, mstat.nr_free, mstat.nr_used_max, mstat.nr_alloc, mstat.nr_release);
+  int n = strlen(info);
+  memset(buf, 0, len);
+  if (offset < n) {
+    memcpy(buf, info + offset, (n - offset < len ? n - offset : len));
+  }
+}
+
+/* The brk() system call handler. Pages are mapped and unmapped as the
+ * program break crosses page boundaries, and are zeroed when mapped.
+ * The heap can not shrink below where it starts, or grow into the area
+ * of mmap(). */
 int mm_brk(uint32_t new_brk) {
+#ifdef HAS_PTE
+  if (current != NULL) {
+    if (new_brk < current->brk_start || new_brk > MMAP_START) {
+      return -1;
+    }
+
+    uintptr_t new_max = PGROUNDUP(new_brk);
+    uintptr_t va;
+    if (new_max > current->max_brk) {
+      if ((new_max - current->max_brk) / PGSIZE > mstat.nr_free) {
+        return -1;
+      }
+      for (va = current->max_brk; va < new_max; va += PGSIZE) {
+        void *pa = new_page();
+        memset(pa, 0, PGSIZE);
+        _map(&current->as, (void *)va, pa);
+      }
+    }
+    else {
+      for (va = new_max; va < current->max_brk; va += PGSIZE) {
+        void *pa = _unmap(&current->as, (void *)va);
+        if (pa != NULL) {
+          free_page(pa);
+        }
+      }
+    }
+    current->max_brk = new_max;
+    current->cur_brk = new_brk;
+  }
+#endif
   return 0;
 }
 
+/* Map the kernel memory [addr, addr + len) into the current process, and
+ * return the user address of `addr'. The pages are shared with the kernel,
+ * so nothing is copied. */
+uintptr_t mm_mmap(const void *addr, size_t len) {
+#ifdef HAS_PTE
+  if (current != NULL) {
+    uintptr_t pa = PGROUNDDOWN((uintptr_t)addr);
+    uintptr_t pa_end = PGROUNDUP((uintptr_t)addr + len);
+    if (current->mmap_brk == 0) {
+      current->mmap_brk = MMAP_START;
+    }
+    uintptr_t va = current->mmap_brk;
+    if (va + (pa_end - pa) > (uintptr_t)current->as.area.end) {
+      return -1;
+    }
+
+    for (; pa < pa_end; pa += PGSIZE, current->mmap_brk += PGSIZE) {
+      _map(&current->as, (void *)current->mmap_brk, (void *)pa);
+    }
+    return va + ((uintptr_t)addr & PGMASK);
+  }
+#endif
+
+  // the kernel is identity mapped
+  return (uintptr_t)addr;
+}
+
+#ifndef HAS_PTE
+/* Without paging, files which can not be mapped in place are copied to
+ * new pages, which are freed by munmap(). */
+#define NR_COPY 16
+static struct {
+  uintptr_t addr;
+  int nr;
+} copies[NR_COPY];
+#endif
+
+/* Map `len' bytes starting from `offset' of the storage read by
+ * fs_storage_read() into the current process, and return the user
+ * address. With paging, the mapping is a segment filled by mm_fault()
+ * page by page on the first touch, as programs are loaded. */
+uintptr_t mm_mmap_file(off_t offset, size_t len) {
+#ifdef HAS_PTE
+  if (current != NULL) {
+    if (current->nr_seg == NR_SEGMENT) {
+      return -1;
+    }
+    if (current->mmap_brk == 0) {
+      current->mmap_brk = MMAP_START;
+    }
+    uintptr_t va = current->mmap_brk;
+    if (va + PGROUNDUP(len) > (uintptr_t)current->as.area.end) {
+      return -1;
+    }
+
+    Segment *seg = &current->seg[current->nr_seg ++];
+    seg->vaddr = va;
+    seg->filesz = seg->memsz = len;
+    seg->offset = offset;
+    current->mmap_brk += PGROUNDUP(len);
+    return va;
+  }
+#else
+  for (int i = 0; i < NR_COPY; i ++) {
+    if (copies[i].nr == 0) {
+      int nr = PGROUNDUP(len) / PGSIZE;
+      void *p = new_pages(nr);
+      if (p == NULL) {
+        return -1;
+      }
+      fs_storage_read(p, offset, len);
+      copies[i].addr = (uintptr_t)p;
+      copies[i].nr = nr;
+      return (uintptr_t)p;
+    }
+  }
+#endif
+  return -1;
+}
+
+#ifdef HAS_PTE
+static bool in_segment(uintptr_t va) {
+  for (int i = 0; i < current->nr_seg; i ++) {
+    Segment *seg = &current->seg[i];
+    if (va + PGSIZE > seg->vaddr && va < seg->vaddr + seg->memsz) {
+      return true;
+    }
+  }
+  return false;
+}
+#endif
+
+int mm_munmap(uintptr_t va, size_t len) {
+#ifdef HAS_PTE
+  if (current != NULL) {
+    if (va < MMAP_START || va + len > current->mmap_brk) {
+      return -1;
+    }
+    uintptr_t start = PGROUNDDOWN(va);
+    uintptr_t end = PGROUNDUP(va + len);
+    for (va = start; va < end; va += PGSIZE) {
+      void *pa = _unmap(&current->as, (void *)va);
+      // pages of files filled on demand are owned by the process
+      if (pa != NULL && in_segment(va)) {
+        free_page(pa);
+      }
+    }
+
+    // forget the mappings of files which are unmapped entirely
+    for (int i = 0; i < current->nr_seg; ) {
+      Segment *seg = &current->seg[i];
+      if (seg->vaddr >= start && seg->vaddr + seg->memsz <= end) {
+        *seg = current->seg[-- current->nr_seg];
+      }
+      else {
+        i ++;
+      }
+    }
+  }
+#else
+  for (int i = 0; i < NR_COPY; i ++) {
+    if (copies[i].nr != 0 && copies[i].addr == va) {
+      free_pages((void *)va, copies[i].nr);
+      copies[i].nr = 0;
+    }
+  }
+#endif
+  return 0;
+}
+
+/* Fill the page containing `va' from the segments of the current process
+ * and map it. Return false if `va' does not belong to any segment. */
+bool mm_fault(uintptr_t va) {
+#ifdef HAS_PTE
+  if (current == NULL) {
+    return false;
+  }
+
+  uintptr_t page = PGROUNDDOWN(va);
+  uint8_t *pa = NULL;
+  for (int i = 0; i < current->nr_seg; i ++) {
+    Segment *seg = &current->seg[i];
+    uintptr_t start = (seg->vaddr > page ? seg->vaddr : page);
+    uintptr_t end = (seg->vaddr + seg->memsz < page + PGSIZE ? seg->vaddr + seg->memsz : page + PGSIZE);
+    if (start >= end) {
+      continue;
+    }
+
+    if (pa == NULL) {
+      pa = new_page();
+      memset(pa, 0, PGSIZE);
+    }
+    // the part beyond `filesz' is .bss, which is left zero
+    uintptr_t file_end = seg->vaddr + seg->filesz;
+    if (start < file_end) {
+      fs_storage_read(pa + (start - page), seg->offset + (start - seg->vaddr),
+          (end < file_end ? end : file_end) - start);
+    }
+  }
+
+  if (pa != NULL) {
+    _map(&current->as, (void *)page, pa);
+    return true;
+  }
+#endif
+  return false;
+}
+
+#ifdef HAS_PTE
+static void unmap_free(uintptr_t start, uintptr_t end) {
+  for (uintptr_t va = PGROUNDDOWN(start); va < end; va += PGSIZE) {
+    void *pa = _unmap(&current->as, (void *)va);
+    if (pa != NULL) {
+      free_page(pa);
+    }
+  }
+}
+#endif
+
+/* Free the pages owned by the current process, which is exiting: those
+ * of its segments, including the mappings of files, and of its heap.
+ * Pages mapped by mm_mmap() belong to the kernel and are only left behind. The page tables are freed by
+ * _release() after switching away from the address space. */
+void mm_release(void) {
+#ifdef HAS_PTE
+  if (current == NULL) {
+    return;
+  }
+  for (int i = 0; i < current->nr_seg; i ++) {
+    Segment *seg = &current->seg[i];
+    unmap_free(seg->vaddr, seg->vaddr + seg->memsz);
+  }
+  current->nr_seg = 0;
+  unmap_free(current->brk_start, current->max_brk);
+#endif
+}
+
 void init_mm() {
-  pf = (void *)PGROUNDUP((uintptr_t)_heap.start);
-  Log("free physical pages starting from %p", pf);
+  // one byte of state for each page, including those holding the states
+  page_state = (void *)_heap.start;
+  int n = ((uintptr_t)_heap.end - (uintptr_t)_heap.start) / PGSIZE;
+  memset(page_state, PAGE_FREE, n);
+  pf = (void *)PGROUNDUP((uintptr_t)_heap.start + n);
+  nr_page = ((uintptr_t)_heap.end - (uintptr_t)pf) / PGSIZE;
+  mstat.nr_free = nr_page;
+  Log("free physical pages starting from %p, %d pages in total", pf, nr_page);
 
+#ifdef HAS_PTE
   _pte_init(new_page, free_page);
+#endif
 }
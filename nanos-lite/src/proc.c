@@ -1,31 +1,120 @@
 #include "proc.h"
 
-#define MAX_NR_PROC 4
+#define MAX_NR_PROC 8
 
 static PCB pcb[MAX_NR_PROC];
 static int nr_proc = 0;
 PCB *current = NULL;
 
-uintptr_t loader(_Protect *as, const char *filename);
+// when `current' was switched to, in milliseconds
+static uint32_t switch_time = 0;
 
-void load_prog(const char *filename) {
+/* Load a program as a new process. It runs for `priority' time slices
+ * in a row when it is scheduled. */
+void load_prog(const char *filename, int priority) {
+  assert(nr_proc < MAX_NR_PROC);
   int i = nr_proc ++;
+#ifdef HAS_PTE
   _protect(&pcb[i].as);
+#endif
+  init_fd_table(pcb[i].fd_table);
 
-  uintptr_t entry = loader(&pcb[i].as, filename);
-
-  // TODO: remove the following three lines after you have implemented _umake()
-  _switch(&pcb[i].as);
-  current = &pcb[i];
-  ((void (*)(void))entry)();
+  uintptr_t entry = loader(&pcb[i], filename);
 
   _Area stack;
   stack.start = pcb[i].stack;
   stack.end = stack.start + sizeof(pcb[i].stack);
 
   pcb[i].tf = _umake(&pcb[i].as, stack, stack, (void *)entry, NULL, NULL);
+  pcb[i].priority = (priority > 0 ? priority : 1);
+  pcb[i].slice = pcb[i].priority;
 }
 
+/* Save the context of the current process and switch to the next one in
+ * round-robin order. The current process is charged for the time since it
+ * was switched to. */
 _RegSet* schedule(_RegSet *prev) {
-  return NULL;
+  if (nr_proc == 0) {
+    return NULL;
+  }
+
+  uint32_t now = _uptime();
+  if (current != NULL) {
+    current->tf = prev;
+    current->runtime += now - switch_time;
+  }
+  switch_time = now;
+
+  // the next live process after the current one
+  int i = (current == NULL ? 0 : (current - pcb + 1) % nr_proc);
+  for (int n = 0; n < nr_proc && pcb[i].dead; n ++) {
+    i = (i + 1) % nr_proc;
+  }
+  PCB *next = &pcb[i];
+  assert(!next->dead);
+
+  next->slice = next->priority;
+  if (next != current) {
+    next->nr_switch ++;
+  }
+  current = next;
+
+#ifdef HAS_PTE
+  _switch(&current->as);
+#endif
+  return current->tf;
+}
+
+/* Terminate the current process and switch to the next live one. Its
+ * files are closed and its memory is freed. The machine halts with
+ * `status' when the last process exits. */
+_RegSet* proc_exit(_RegSet *prev, int status) {
+  if (current == NULL) {
+    _halt(status);
+  }
+
+  Log("process %d exited with status %d", (int)(current - pcb), status);
+  close_fd_table(current->fd_table);
+  mm_release();
+  current->ring = NULL;
+  current->dead = true;
+
+  int nr_live = 0;
+  for (int i = 0; i < nr_proc; i ++) {
+    if (!pcb[i].dead) {
+      nr_live ++;
+    }
+  }
+  if (nr_live == 0) {
+    _halt(status);
+  }
+
+#ifdef HAS_PTE
+  // the page tables can be freed once another address space is in use
+  _Protect *as = &current->as;
+  _RegSet *next = schedule(prev);
+  _release(as);
+  return next;
+#else
+  return schedule(prev);
+#endif
+}
+
+/* Called on every timer interrupt. The current process keeps running
+ * until its time slices are used up. */
+_RegSet* schedule_tick(_RegSet *prev) {
+  ring_poll();
+  if (current != NULL && -- current->slice > 0) {
+    return NULL;
+  }
+  return schedule(prev);
+}
+
+/* CPU time of the current process in milliseconds, including the time
+ * spent in the kernel on behalf of it. */
+uint32_t proc_runtime(void) {
+  if (current == NULL) {
+    return _uptime();
+  }
+  return current->runtime + (_uptime() - switch_time);
 }
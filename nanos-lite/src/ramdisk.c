@@ -1,31 +1,208 @@
 #include "common.h"
+#include "memory.h"
 
-extern uint8_t ramdisk_start;
-extern uint8_t ramdisk_end;
-#define RAMDISK_SIZE ((&ramdisk_end) - (&ramdisk_start))
+extern uint8_t ramdisk_start[], ramdisk_end[];
+#define RAMDISK_SIZE (ramdisk_end - ramdisk_start)
 
 /* The kernel is monolithic, therefore we do not need to
  * translate the address `buf' from the user process to
  * a physical one, which is necessary for a microkernel.
  */
 
+/* The image built by tools/mkrdz is compressed in chunks, which are
+ * decompressed on demand into a small cache. A chunk is written in a copy
+ * of its own, which stays in memory since it can not be compressed back.
+ * Any other image is used as is.
+ */
+
+#define RDZ_MAGIC 0x5a44524e  // "NRDZ"
+#define NR_CHUNK_CACHE 8
+
+typedef struct {
+  uint32_t magic;
+  uint32_t chunk_size;
+  uint32_t nr_chunk;
+  uint32_t size;        // of the raw image
+  uint32_t index[];     // chunk i is in [index[i], index[i + 1]) of the image
+} RdzHeader;
+
+static const RdzHeader *rdz = NULL;
+static uint8_t **written_chunk;
+
+static struct {
+  int chunk;
+  uint32_t last_use;
+  uint8_t *data;
+} cache[NR_CHUNK_CACHE];
+static uint32_t nr_use = 0;
+
+/* memory for the contents of a chunk, which must be contiguous */
+static uint8_t* new_chunk_pages() {
+  uint8_t *p = new_pages(PGROUNDUP(rdz->chunk_size) / PGSIZE);
+  if (p == NULL) {
+    panic("no memory for a chunk of %d bytes of ramdisk", rdz->chunk_size);
+  }
+  return p;
+}
+
+/* Decompress a block of the LZ4 format, and return the size of the output.
+ * A match may overlap its output, so it is copied byte by byte. */
+static size_t lz4_decompress(const uint8_t *src, size_t len, uint8_t *dst) {
+  const uint8_t *end = src + len;
+  uint8_t *op = dst;
+  while (src < end) {
+    uint8_t token = *src ++;
+    size_t n = token >> 4;
+    if (n == 15) {
+      uint8_t b;
+      do { b = *src ++; n += b; } while (b == 255);
+    }
+    memcpy(op, src, n);
+    op += n;
+    src += n;
+    if (src >= end) {
+      break;
+    }
+
+    size_t off = src[0] | (src[1] << 8);
+    src += 2;
+    n = (token & 0xf) + 4;
+    if ((token & 0xf) == 0xf) {
+      uint8_t b;
+      do { b = *src ++; n += b; } while (b == 255);
+    }
+    for (const uint8_t *m = op - off; n > 0; n --) {
+      *op ++ = *m ++;
+    }
+  }
+  return op - dst;
+}
+
+static size_t chunk_len(int chunk) {
+  size_t start = (size_t)chunk * rdz->chunk_size;
+  return (rdz->size - start < rdz->chunk_size ? rdz->size - start : rdz->chunk_size);
+}
+
+static void decompress_chunk(int chunk, uint8_t *dst) {
+  const uint8_t *src = (const uint8_t *)rdz + rdz->index[chunk];
+  size_t clen = rdz->index[chunk + 1] - rdz->index[chunk];
+  size_t len = chunk_len(chunk);
+  if (clen == len) {
+    // stored as is
+    memcpy(dst, src, len);
+  }
+  else {
+    size_t n = lz4_decompress(src, clen, dst);
+    assert(n == len);
+  }
+}
+
+/* Return the contents of `chunk', decompressing it into the least
+ * recently used entry of the cache on a miss. */
+static uint8_t* get_chunk(int chunk) {
+  if (written_chunk[chunk] != NULL) {
+    return written_chunk[chunk];
+  }
+
+  int victim = 0;
+  for (int i = 0; i < NR_CHUNK_CACHE; i ++) {
+    if (cache[i].chunk == chunk) {
+      cache[i].last_use = ++ nr_use;
+      return cache[i].data;
+    }
+    if (cache[i].last_use < cache[victim].last_use) {
+      victim = i;
+    }
+  }
+
+  decompress_chunk(chunk, cache[victim].data);
+  cache[victim].chunk = chunk;
+  cache[victim].last_use = ++ nr_use;
+  return cache[victim].data;
+}
+
 /* read `len' bytes starting from `offset' of ramdisk into `buf' */
 void ramdisk_read(void *buf, off_t offset, size_t len) {
-  assert(offset + len <= RAMDISK_SIZE);
-  memcpy(buf, &ramdisk_start + offset, len);
+  if (rdz == NULL) {
+    assert(offset + len <= RAMDISK_SIZE);
+    memcpy(buf, ramdisk_start + offset, len);
+    return;
+  }
+
+  assert(offset + len <= rdz->size);
+  while (len > 0) {
+    int chunk = offset / rdz->chunk_size;
+    size_t off = offset % rdz->chunk_size;
+    size_t n = (len < rdz->chunk_size - off ? len : rdz->chunk_size - off);
+    memcpy(buf, get_chunk(chunk) + off, n);
+    buf = (uint8_t *)buf + n;
+    offset += n;
+    len -= n;
+  }
 }
 
 /* write `len' bytes starting from `buf' into the `offset' of ramdisk */
 void ramdisk_write(const void *buf, off_t offset, size_t len) {
+  if (rdz == NULL) {
+    assert(offset + len <= RAMDISK_SIZE);
+    memcpy(ramdisk_start + offset, buf, len);
+    return;
+  }
+
+  assert(offset + len <= rdz->size);
+  while (len > 0) {
+    int chunk = offset / rdz->chunk_size;
+    size_t off = offset % rdz->chunk_size;
+    size_t n = (len < rdz->chunk_size - off ? len : rdz->chunk_size - off);
+    if (written_chunk[chunk] == NULL) {
+      written_chunk[chunk] = new_chunk_pages();
+      decompress_chunk(chunk, written_chunk[chunk]);
+    }
+    memcpy(written_chunk[chunk] + off, buf, n);
+    buf = (const uint8_t *)buf + n;
+    offset += n;
+    len -= n;
+  }
+}
+
+/* return the address of `len' bytes starting from `offset' of ramdisk,
+ * which can be accessed in place without copying, or NULL if ramdisk is
+ * compressed */
+void* ramdisk_map(off_t offset, size_t len) {
+  if (rdz != NULL) {
+    return NULL;
+  }
   assert(offset + len <= RAMDISK_SIZE);
-  memcpy(&ramdisk_start + offset, buf, len);
+  return ramdisk_start + offset;
 }
 
 void init_ramdisk() {
   Log("ramdisk info: start = %p, end = %p, size = %d bytes",
-      &ramdisk_start, &ramdisk_end, RAMDISK_SIZE);
+      ramdisk_start, ramdisk_end, RAMDISK_SIZE);
+
+  if (RAMDISK_SIZE < sizeof(RdzHeader) || ((RdzHeader *)ramdisk_start)->magic != RDZ_MAGIC) {
+    return;
+  }
+  if (((RdzHeader *)ramdisk_start)->nr_chunk == 0) {
+    return;
+  }
+  rdz = (RdzHeader *)ramdisk_start;
+
+  size_t n = sizeof(uint8_t *) * rdz->nr_chunk;
+  written_chunk = new_pages(PGROUNDUP(n) / PGSIZE);
+  if (written_chunk == NULL) {
+    panic("no memory for the list of %d chunks of ramdisk", rdz->nr_chunk);
+  }
+  memset(written_chunk, 0, n);
+  for (int i = 0; i < NR_CHUNK_CACHE; i ++) {
+    cache[i].chunk = -1;
+    cache[i].last_use = 0;
+    cache[i].data = new_chunk_pages();
+  }
+  Log("ramdisk is compressed: %d bytes in %d chunks of %d bytes",
+      rdz->size, rdz->nr_chunk, rdz->chunk_size);
 }
 
 size_t get_ramdisk_size() {
-  return RAMDISK_SIZE;
+  return (rdz == NULL ? RAMDISK_SIZE : rdz->size);
 }
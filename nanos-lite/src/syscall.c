@@ -1,33 +1,24 @@
 #include "common.h"
 #include "syscall.h"
 #include "fs.h"
+#include "memory.h"
+#include "proc.h"
 
 int sys_none() {
   return 1;
 }
 
-void sys_exit(int a){
-  _halt(a);
+_RegSet* sys_exit(_RegSet *r, int status) {
+  return proc_exit(r, status);
 }
 
 int sys_write(int fd, void *buf, size_t len) {
-	if(fd == 1 || fd == 2){
-    //Log("sys_write: fd=%d, len=%d, buffer:%s", fd, len, (char*)buf);
-
-		for(int i = 0; i < len; i++) {
-			_putc(((char*) buf)[i]);
-		}
-		return len;
-	}
-  if(fd >= 3) {
-    return fs_write(fd, buf, len);
-  }
-	return -1;			
+  return fs_write(fd, buf, len);
 }
 
 
-int sys_brk(int addr) {
-  return 0;
+int sys_brk(uintptr_t addr) {
+  return mm_brk(addr);
 }
 
 int sys_open(const char *pathname){
@@ -45,20 +36,157 @@ int sys_lseek(int fd, off_t offset, int whence) {
 int sys_close(int fd){
     return fs_close(fd);
 }
+
+int sys_fstat(int fd) {
+    return fs_stat(fd);
+}
+
+int sys_pread(int fd, void *buf, size_t len, off_t offset) {
+    return fs_pread(fd, buf, len, offset);
+}
+
+int sys_pwrite(int fd, const void *buf, size_t len, off_t offset) {
+    return fs_pwrite(fd, buf, len, offset);
+}
+/* Files are mapped from ramdisk directly, and can only be read.
+ * /dev/fb is mapped to the frame buffer and can also be written.
+ * Files which are compressed or on the disk are read into pages of
+ * the process instead. */
+uintptr_t sys_mmap(size_t len, int prot, int fd, off_t offset) {
+    if (prot & ~(PROT_READ | PROT_WRITE)) {
+        return -1;
+    }
+    bool writable = (prot & PROT_WRITE) != 0;
+    void *addr = fs_mmap(fd, offset, len, writable);
+    if (addr != NULL) {
+        return mm_mmap(addr, len);
+    }
+
+    off_t start = fs_disk_offset(fd);
+    if (start < 0 || writable || len == 0 || offset < 0 ||
+        offset > fs_filesz(fd) || len > fs_filesz(fd) - offset) {
+        return -1;
+    }
+    return mm_mmap_file(start + offset, len);
+}
+
+int sys_munmap(uintptr_t addr, size_t len) {
+    return mm_munmap(addr, len);
+}
+
+/* Fill `struct tms' of newlib, whose four fields are clock_t in
+ * milliseconds, and return the milliseconds since boot. */
+int sys_times(uint32_t *tms) {
+    tms[0] = proc_runtime();
+    tms[1] = tms[2] = tms[3] = 0;
+    return _uptime();
+}
+
+/* `struct timeval' is {long tv_sec; long tv_usec;} */
+int sys_gettimeofday(uint32_t *tv) {
+    uint32_t ms = _uptime();
+    tv[0] = ms / 1000;
+    tv[1] = ms % 1000 * 1000;
+    return 0;
+}
+
+/* The submission and completion rings of a process, in its memory. They
+ * are the same as `Ring' in <sys/ring.h> of Navy-apps. The process queues
+ * operations at `sq_tail' and reaps results at `cq_head'; the kernel
+ * consumes operations at `sq_head' and adds results at `cq_tail'. */
+enum { RING_READ = 1, RING_WRITE, RING_LSEEK, RING_PREAD, RING_PWRITE, RING_BLIT };
+
+#define RING_POLL 0x1   // the ring is also drained on timer interrupts
+
+typedef struct {
+  uint32_t op;
+  int32_t fd;
+  uint32_t addr;    // the buffer, or the rectangles written to /dev/fbctl by RING_BLIT
+  uint32_t len;     // bytes, or whence of RING_LSEEK
+  int32_t offset;
+  uint32_t data;    // passed to the completion as is
+} RingSqe;
+
+typedef struct {
+  uint32_t data;
+  int32_t res;
+} RingCqe;
+
+typedef struct {
+  volatile uint32_t sq_head, sq_tail;
+  volatile uint32_t cq_head, cq_tail;
+  uint32_t sq_size, cq_size;    // powers of 2
+  uint32_t flags;
+  RingSqe *sq;
+  RingCqe *cq;
+} Ring;
+
+extern size_t fbctl_write(const void *buf, size_t len);
+
+static int ring_exec(const RingSqe *e) {
+  switch (e->op) {
+    case RING_READ:   return sys_read(e->fd, (void *)e->addr, e->len);
+    case RING_WRITE:  return sys_write(e->fd, (void *)e->addr, e->len);
+    case RING_LSEEK:  return sys_lseek(e->fd, e->offset, e->len);
+    case RING_PREAD:  return sys_pread(e->fd, (void *)e->addr, e->len, e->offset);
+    case RING_PWRITE: return sys_pwrite(e->fd, (void *)e->addr, e->len, e->offset);
+    case RING_BLIT:   return fbctl_write((void *)e->addr, e->len);
+    default: return -1;
+  }
+}
+
+/* Execute the queued operations in order while there is room for their
+ * completions, and return the number of operations executed. */
+static int ring_drain(Ring *ring) {
+  int n = 0;
+  while (ring->sq_head != ring->sq_tail && ring->cq_tail - ring->cq_head < ring->cq_size) {
+    const RingSqe *e = &ring->sq[ring->sq_head & (ring->sq_size - 1)];
+    RingCqe *c = &ring->cq[ring->cq_tail & (ring->cq_size - 1)];
+    c->data = e->data;
+    c->res = ring_exec(e);
+    ring->cq_tail ++;
+    ring->sq_head ++;
+    n ++;
+  }
+  return n;
+}
+
+int sys_ring_setup(Ring *ring) {
+  if (ring != NULL && (ring->sq_size == 0 || (ring->sq_size & (ring->sq_size - 1)) != 0 ||
+        ring->cq_size == 0 || (ring->cq_size & (ring->cq_size - 1)) != 0)) {
+    return -1;
+  }
+  current->ring = ring;
+  return 0;
+}
+
+int sys_ring_enter(void) {
+  return (current->ring == NULL ? -1 : ring_drain(current->ring));
+}
+
+/* Called on timer interrupts, with the address space of the current
+ * process, to drain its ring if it asked for polling. */
+void ring_poll(void) {
+  Ring *ring = (current == NULL ? NULL : current->ring);
+  if (ring != NULL && (ring->flags & RING_POLL)) {
+    ring_drain(ring);
+  }
+}
+
 _RegSet* do_syscall(_RegSet *r) {
-  uintptr_t a[4];
+  uintptr_t a[5];
   a[0] = SYSCALL_ARG1(r);
   a[1] = SYSCALL_ARG2(r);
   a[2] = SYSCALL_ARG3(r);
   a[3] = SYSCALL_ARG4(r);
+  a[4] = SYSCALL_ARG5(r);
 
   switch (a[0]) {
     case SYS_none: 
       SYSCALL_ARG1(r) = sys_none();
       break;
     case SYS_exit: 
-      sys_exit(a[1]);
-      break;
+      return sys_exit(r, a[1]);
     case SYS_write:
       SYSCALL_ARG1(r) = sys_write(a[1], (void*)a[2], a[3]);
       break;
@@ -77,6 +205,36 @@ _RegSet* do_syscall(_RegSet *r) {
     case SYS_lseek:
       SYSCALL_ARG1(r)=sys_lseek(a[1],a[2],a[3]);
       break;
+    case SYS_fstat:
+      SYSCALL_ARG1(r) = sys_fstat(a[1]);
+      break;
+    case SYS_pread:
+      SYSCALL_ARG1(r) = sys_pread(a[1], (void*)a[2], a[3], a[4]);
+      break;
+    case SYS_pwrite:
+      SYSCALL_ARG1(r) = sys_pwrite(a[1], (void*)a[2], a[3], a[4]);
+      break;
+    case SYS_mmap:
+      SYSCALL_ARG1(r) = sys_mmap(a[1], a[2], a[3], a[4]);
+      break;
+    case SYS_munmap:
+      SYSCALL_ARG1(r) = sys_munmap(a[1], a[2]);
+      break;
+    case SYS_times:
+      SYSCALL_ARG1(r) = sys_times((uint32_t*)a[1]);
+      break;
+    case SYS_gettimeofday:
+      SYSCALL_ARG1(r) = sys_gettimeofday((uint32_t*)a[1]);
+      break;
+    case SYS_yield:
+      SYSCALL_ARG1(r) = 0;
+      return schedule(r);
+    case SYS_ring_setup:
+      SYSCALL_ARG1(r) = (current == NULL ? -1 : sys_ring_setup((Ring*)a[1]));
+      break;
+    case SYS_ring_enter:
+      SYSCALL_ARG1(r) = (current == NULL ? -1 : sys_ring_enter());
+      break;
     default: panic("Unhandled syscall ID = %d", a[0]);
   }
 
@@ -0,0 +1,148 @@
+/* Compress a ramdisk image into independently decompressible chunks.
+ *
+ *   mkrdz <raw image> <compressed image>
+ *
+ * The output starts with a header and an index of nr_chunk + 1 offsets,
+ * where chunk i is stored in [index[i], index[i + 1]) of the output. Every
+ * chunk is in the LZ4 block format, or stored as is if it does not get
+ * smaller. It is read by src/ramdisk.c.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define RDZ_MAGIC 0x5a44524e  // "NRDZ"
+#define CHUNK_SIZE (16 * 1024)
+
+#define MIN_MATCH 4
+#define LAST_LITERALS 5   // the last bytes of a block are always literals
+#define MF_LIMIT 12       // a match must start this far before the end
+#define HASH_BITS 12
+
+static uint32_t read32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, 4);
+  return v;
+}
+
+static uint32_t hash(uint32_t v) {
+  return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static uint8_t *put_len(uint8_t *op, size_t len) {
+  for (; len >= 255; len -= 255) {
+    *op ++ = 255;
+  }
+  *op ++ = len;
+  return op;
+}
+
+static uint8_t *put_sequence(uint8_t *op, const uint8_t *lit, size_t nr_lit, size_t off, size_t match_len) {
+  uint8_t *token = op ++;
+  *token = (nr_lit < 15 ? nr_lit : 15) << 4;
+  if (nr_lit >= 15) {
+    op = put_len(op, nr_lit - 15);
+  }
+  memcpy(op, lit, nr_lit);
+  op += nr_lit;
+
+  if (match_len > 0) {
+    *op ++ = off & 0xff;
+    *op ++ = off >> 8;
+    match_len -= MIN_MATCH;
+    *token |= (match_len < 15 ? match_len : 15);
+    if (match_len >= 15) {
+      op = put_len(op, match_len - 15);
+    }
+  }
+  return op;
+}
+
+/* Greedy LZ4 compression of one chunk, return the compressed size. */
+static size_t compress(const uint8_t *src, size_t n, uint8_t *dst) {
+  static const uint8_t *table[1 << HASH_BITS];
+  memset(table, 0, sizeof(table));
+
+  const uint8_t *ip = src, *anchor = src;
+  const uint8_t *match_limit = (n >= MF_LIMIT ? src + n - MF_LIMIT : src);
+  const uint8_t *end = src + n - LAST_LITERALS;
+  uint8_t *op = dst;
+
+  while (ip < match_limit) {
+    uint32_t h = hash(read32(ip));
+    const uint8_t *ref = table[h];
+    table[h] = ip;
+    if (ref == NULL || ip - ref > 0xffff || read32(ref) != read32(ip)) {
+      ip ++;
+      continue;
+    }
+
+    size_t len = MIN_MATCH;
+    while (ip + len < end && ref[len] == ip[len]) {
+      len ++;
+    }
+    op = put_sequence(op, anchor, ip - anchor, ip - ref, len);
+    ip += len;
+    anchor = ip;
+  }
+
+  op = put_sequence(op, anchor, src + n - anchor, 0, 0);
+  return op - dst;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    fprintf(stderr, "Usage: %s <raw image> <compressed image>\n", argv[0]);
+    return 1;
+  }
+
+  FILE *fp = fopen(argv[1], "rb");
+  if (fp == NULL) { perror(argv[1]); return 1; }
+  fseek(fp, 0, SEEK_END);
+  size_t size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  uint8_t *raw = malloc(size + 1);
+  if (size > 0 && fread(raw, size, 1, fp) != 1) { perror(argv[1]); return 1; }
+  fclose(fp);
+
+  uint32_t nr_chunk = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  size_t header_size = (4 + nr_chunk + 1) * sizeof(uint32_t);
+  uint32_t *header = malloc(header_size);
+  header[0] = RDZ_MAGIC;
+  header[1] = CHUNK_SIZE;
+  header[2] = nr_chunk;
+  header[3] = size;
+  uint32_t *index = &header[4];
+
+  // the worst case of LZ4 is a little larger than the input
+  uint8_t *out = malloc(size + size / 255 + 16 * (nr_chunk + 1));
+  size_t out_size = 0;
+  uint8_t buf[CHUNK_SIZE + CHUNK_SIZE / 255 + 16];
+  for (uint32_t i = 0; i < nr_chunk; i ++) {
+    const uint8_t *chunk = raw + (size_t)i * CHUNK_SIZE;
+    size_t len = (size - (size_t)i * CHUNK_SIZE < CHUNK_SIZE ? size - (size_t)i * CHUNK_SIZE : CHUNK_SIZE);
+    size_t n = compress(chunk, len, buf);
+    index[i] = header_size + out_size;
+    if (n < len) {
+      memcpy(out + out_size, buf, n);
+      out_size += n;
+    }
+    else {
+      memcpy(out + out_size, chunk, len);
+      out_size += len;
+    }
+  }
+  index[nr_chunk] = header_size + out_size;
+
+  fp = fopen(argv[2], "wb");
+  if (fp == NULL) { perror(argv[2]); return 1; }
+  fwrite(header, header_size, 1, fp);
+  fwrite(out, out_size, 1, fp);
+  fclose(fp);
+
+  printf("ramdisk: %zu bytes in %u chunks, compressed to %zu bytes\n",
+      size, nr_chunk, header_size + out_size);
+  return 0;
+}
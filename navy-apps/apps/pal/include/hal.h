@@ -61,6 +61,7 @@ typedef struct {
 #define SDL_PHYSPAL 0x2
 #define SDL_LOGPAL 0x4
 #define SDL_SWSURFACE  0x8
+#define SDL_SRCCOLORKEY 0x10
 
 typedef union {
 	uint8_t type;
@@ -97,6 +98,7 @@ void SDL_FreeSurface(SDL_Surface *);
 void SDL_SoftStretch(SDL_Surface *, SDL_Rect *, SDL_Surface *, SDL_Rect *);
 void SDL_UpdateRect(SDL_Surface *, int, int, int, int);
 void SDL_FillRect(SDL_Surface *, SDL_Rect *, uint32_t);
+int SDL_SetColorKey(SDL_Surface *, uint32_t, uint32_t);
 
 int SDL_PollEvent(SDL_Event *);
 int SDL_LockSurface(SDL_Surface *);
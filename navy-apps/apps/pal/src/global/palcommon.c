@@ -22,6 +22,39 @@
 //
 
 #include "palcommon.h"
+#include <unistd.h>
+
+static INT
+PAL_MKFRead(
+   LPVOID          lpBuffer,
+   UINT            uiSize,
+   UINT            uiOffset,
+   FILE           *fp
+)
+/*++
+  Purpose:
+
+    Read data at the specified offset of an MKF archive with a single
+    positioned read, which does not move the file position of fp.
+
+  Parameters:
+
+    [OUT] lpBuffer - pointer to the destination buffer.
+
+    [IN]  uiSize - number of bytes to read.
+
+    [IN]  uiOffset - offset in the MKF archive.
+
+    [IN]  fp - pointer to the fopen'ed MKF file.
+
+  Return value:
+
+    Number of bytes read, or -1 on error.
+
+--*/
+{
+   return pread(fileno(fp), lpBuffer, uiSize, uiOffset);
+}
 
 INT
 PAL_RLEBlitToSurface(
@@ -675,8 +708,7 @@ PAL_MKFGetChunkCount(
       return 0;
    }
 
-   fseek(fp, 0, SEEK_SET);
-   fread(&iNumChunk, sizeof(INT), 1, fp);
+   PAL_MKFRead(&iNumChunk, sizeof(INT), 0, fp);
 
    iNumChunk = (SWAP32(iNumChunk) - 4) / 4;
    return iNumChunk;
@@ -708,6 +740,7 @@ PAL_MKFGetChunkSize(
    UINT    uiOffset       = 0;
    UINT    uiNextOffset   = 0;
    UINT    uiChunkCount   = 0;
+   UINT    buf[2];
 
    //
    // Get the total number of chunks.
@@ -721,11 +754,9 @@ PAL_MKFGetChunkSize(
    //
    // Get the offset of the specified chunk and the next chunk.
    //
-   fseek(fp, 4 * uiChunkNum, SEEK_SET);
-   fread(&uiOffset, sizeof(UINT), 1, fp);
-   fread(&uiNextOffset, sizeof(UINT), 1, fp);
-   uiOffset = SWAP32(uiOffset);
-   uiNextOffset = SWAP32(uiNextOffset);
+   PAL_MKFRead(buf, sizeof(buf), 4 * uiChunkNum, fp);
+   uiOffset = SWAP32(buf[0]);
+   uiNextOffset = SWAP32(buf[1]);
 
    //
    // Return the length of the chunk.
@@ -767,6 +798,7 @@ PAL_MKFReadChunk(
    UINT     uiNextOffset   = 0;
    UINT     uiChunkCount;
    UINT     uiChunkLen;
+   UINT     buf[2];
 
    if (lpBuffer == NULL || fp == NULL || uiBufferSize == 0)
    {
@@ -786,11 +818,9 @@ PAL_MKFReadChunk(
    //
    // Get the offset of the chunk.
    //
-   fseek(fp, 4 * uiChunkNum, SEEK_SET);
-   fread(&uiOffset, 4, 1, fp);
-   fread(&uiNextOffset, 4, 1, fp);
-   uiOffset = SWAP32(uiOffset);
-   uiNextOffset = SWAP32(uiNextOffset);
+   PAL_MKFRead(buf, sizeof(buf), 4 * uiChunkNum, fp);
+   uiOffset = SWAP32(buf[0]);
+   uiNextOffset = SWAP32(buf[1]);
 
    //
    // Get the length of the chunk.
@@ -804,8 +834,7 @@ PAL_MKFReadChunk(
 
    if (uiChunkLen != 0)
    {
-      fseek(fp, uiOffset, SEEK_SET);
-      fread(lpBuffer, uiChunkLen, 1, fp);
+      PAL_MKFRead(lpBuffer, uiChunkLen, uiOffset, fp);
    }
    else
    {
@@ -859,21 +888,19 @@ PAL_MKFGetDecompressedSize(
    //
    // Get the offset of the chunk.
    //
-   fseek(fp, 4 * uiChunkNum, SEEK_SET);
-   fread(&uiOffset, 4, 1, fp);
+   PAL_MKFRead(&uiOffset, 4, 4 * uiChunkNum, fp);
    uiOffset = SWAP32(uiOffset);
 
    //
    // Read the header.
    //
-   fseek(fp, uiOffset, SEEK_SET);
 #ifdef PAL_WIN95
-   fread(buf, sizeof(DWORD), 1, fp);
+   PAL_MKFRead(buf, sizeof(DWORD), uiOffset, fp);
    buf[0] = SWAP32(buf[0]);
 
    return (INT)buf[0];
 #else
-   fread(buf, sizeof(DWORD), 2, fp);
+   PAL_MKFRead(buf, sizeof(DWORD) * 2, uiOffset, fp);
    buf[0] = SWAP32(buf[0]);
    buf[1] = SWAP32(buf[1]);
 
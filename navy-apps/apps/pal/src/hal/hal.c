@@ -93,13 +93,99 @@ static intptr_t VMEM_ADDR = (intptr_t)&vmem[0];
 
 static uint32_t palette[256];
 
+// rectangles of `vmem' which changed since they were last drawn
+#define NR_DIRTY 16
+static SDL_Rect dirty[NR_DIRTY];
+static int nr_dirty = 0;
+
+static void mark_dirty(int x, int y, int w, int h) {
+  if (x < 0) { w += x; x = 0; }
+  if (y < 0) { h += y; y = 0; }
+  if (x + w > W) { w = W - x; }
+  if (y + h > H) { h = H - y; }
+  if (w <= 0 || h <= 0) return;
+
+  for (int i = 0; i < nr_dirty; i ++) {
+    SDL_Rect *r = &dirty[i];
+    if (x >= r->x && y >= r->y && x + w <= r->x + r->w && y + h <= r->y + r->h) return;
+  }
+
+  if (nr_dirty == NR_DIRTY) {
+    // too many: draw the box around all of them
+    int x1 = x + w, y1 = y + h;
+    for (int i = 0; i < nr_dirty; i ++) {
+      SDL_Rect *r = &dirty[i];
+      if (r->x < x) x = r->x;
+      if (r->y < y) y = r->y;
+      if (r->x + r->w > x1) x1 = r->x + r->w;
+      if (r->y + r->h > y1) y1 = r->y + r->h;
+    }
+    nr_dirty = 0;
+    w = x1 - x;
+    h = y1 - y;
+  }
+
+  dirty[nr_dirty].x = x;
+  dirty[nr_dirty].y = y;
+  dirty[nr_dirty].w = w;
+  dirty[nr_dirty].h = h;
+  nr_dirty ++;
+}
+
+static void convert_row(uint32_t *dst, const uint8_t *src, int n) {
+  for (; n >= 4; n -= 4, src += 4, dst += 4) {
+    dst[0] = palette[src[0]];
+    dst[1] = palette[src[1]];
+    dst[2] = palette[src[2]];
+    dst[3] = palette[src[3]];
+  }
+  for (; n > 0; n --) {
+    *dst ++ = palette[*src ++];
+  }
+}
+
+// convert the dirty rectangles of `vmem' to `fb' and draw only them
 static void redraw() {
-  for (int i = 0; i < W; i ++)
-    for (int j = 0; j < H; j ++)
-      fb[i + j * W] = palette[vmem[i + j * W]];
+  for (int i = 0; i < nr_dirty; i ++) {
+    SDL_Rect *r = &dirty[i];
+    for (int j = r->y; j < r->y + r->h; j ++) {
+      convert_row(&fb[r->x + j * W], &vmem[r->x + j * W], r->w);
+    }
+    NDL_UpdateRect(&fb[r->x + r->y * W], r->x, r->y, r->w, r->h, W);
+  }
+  nr_dirty = 0;
+}
 
-  NDL_DrawRect(fb, 0, 0, W, H);
-  NDL_Render();
+// true if any byte of the word `x' is zero
+#define HAS_ZERO_BYTE(x) (((x) - 0x01010101u) & ~(x) & 0x80808080u)
+
+// copy `n' pixels from `src' to `dst' except those of index `key'
+static void copy_row_key(uint8_t *dst, const uint8_t *src, int n, uint8_t key) {
+  for (; n > 0 && ((uintptr_t)src & 3); n --, src ++, dst ++) {
+    if (*src != key) *dst = *src;
+  }
+
+  uint32_t keys = key * 0x01010101u;
+  int dst_aligned = !((uintptr_t)dst & 3);
+  for (; n >= 4; n -= 4, src += 4, dst += 4) {
+    uint32_t w = *(const uint32_t *)src;
+    if (w == keys) continue;
+    if (!HAS_ZERO_BYTE(w ^ keys)) {
+      // no transparent pixel among these four
+      if (dst_aligned) *(uint32_t *)dst = w;
+      else { dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; dst[3] = src[3]; }
+    }
+    else {
+      if (src[0] != key) dst[0] = src[0];
+      if (src[1] != key) dst[1] = src[1];
+      if (src[2] != key) dst[2] = src[2];
+      if (src[3] != key) dst[3] = src[3];
+    }
+  }
+
+  for (; n > 0; n --, src ++, dst ++) {
+    if (*src != key) *dst = *src;
+  }
 }
 
 void SDL_BlitSurface(SDL_Surface *src, SDL_Rect *srcrect, 
@@ -118,18 +204,46 @@ void SDL_BlitSurface(SDL_Surface *src, SDL_Rect *srcrect,
     dstrect->w = w;
     dstrect->h = h;
   }
+  if (w <= 0 || h <= 0) return;
 
   /* copy pixels from position (`sx', `sy') with size
    * `w' X `h' of `src' surface to position (`dx', `dy') of
-   * `dst' surface.
+   * `dst' surface. Pixels of the color key of `src' are left
+   * out if it has one.
    */
 
   //fprintf(stderr, "(%d, %d) -> (%d, %d), %d x %d\n", sx, sy, dx, dy, w, h);
-  for (int i = 0; i < w; i ++)
-    for (int j = 0; j < h; j ++) {
-      uint8_t idx = src->pixels[(sx + i) + (sy + j) * src->w];
-      dst->pixels[(dx + i) + (dy + j) * dst->w] = idx;
+  uint8_t *d = &dst->pixels[dx + dy * dst->pitch];
+  uint8_t *s = &src->pixels[sx + sy * src->pitch];
+
+  if (src->flags & SDL_SRCCOLORKEY) {
+    uint8_t key = src->format->colorkey;
+    for (int j = 0; j < h; j ++, d += dst->pitch, s += src->pitch) {
+      copy_row_key(d, s, w, key);
+    }
+    if (dst->pixels == (void *)VMEM_ADDR) {
+      mark_dirty(dx, dy, w, h);
+    }
+    return;
+  }
+
+  if (dst->pixels == (void *)VMEM_ADDR) {
+    // only the rows which really change have to be drawn again
+    int first = -1, last = -1;
+    for (int j = 0; j < h; j ++, d += dst->pitch, s += src->pitch) {
+      if (memcmp(d, s, w) != 0) {
+        memcpy(d, s, w);
+        if (first < 0) first = j;
+        last = j;
+      }
     }
+    if (first >= 0) mark_dirty(dx, dy + first, w, last - first + 1);
+    return;
+  }
+
+  for (int j = 0; j < h; j ++, d += dst->pitch, s += src->pitch) {
+    memcpy(d, s, w);
+  }
 }
 
 void SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, uint32_t color) {
@@ -142,17 +256,38 @@ void SDL_FillRect(SDL_Surface *dst, SDL_Rect *dstrect, uint32_t color) {
   int h = (dstrect == NULL ? dst->h : dstrect->h);
   if(dst->w - dx < w) { w = dst->w - dx; }
   if(dst->h - dy < h) { h = dst->h - dy; }
-
-  // TODO: color is uint32_t, what about palette?
-  for (int i = 0; i < w; i ++)
-    for (int j = 0; j < h; j ++) {
-      dst->pixels[(dx + i) + (dy + j) * dst->w] = color;
-    }
+  if (w <= 0 || h <= 0) return;
 
   /* Fill the rectangle area described by `dstrect'
    * in surface `dst' with color `color'. If dstrect is
    * NULL, fill the whole surface.
    */
+
+  // TODO: color is uint32_t, what about palette?
+  uint8_t *d = &dst->pixels[dx + dy * dst->pitch];
+  if (w == dst->pitch) {
+    // whole rows are one run of memory
+    memset(d, color, w * h);
+  }
+  else {
+    for (int j = 0; j < h; j ++, d += dst->pitch) {
+      memset(d, color, w);
+    }
+  }
+
+  if (dst->pixels == (void *)VMEM_ADDR) {
+    mark_dirty(dx, dy, w, h);
+  }
+}
+
+int SDL_SetColorKey(SDL_Surface *s, uint32_t flag, uint32_t key) {
+  assert(s);
+  assert(s->format);
+  assert(key <= 0xff);
+
+  s->flags = (s->flags & ~SDL_SRCCOLORKEY) | (flag & SDL_SRCCOLORKEY);
+  s->format->colorkey = key;
+  return 0;
 }
 
 void SDL_SetPalette(SDL_Surface *s, int flags, SDL_Color *colors, 
@@ -187,6 +322,8 @@ void SDL_SetPalette(SDL_Surface *s, int flags, SDL_Color *colors,
       uint8_t b = colors[i].b;
       palette[i] = (r << 16) | (g << 8) | b;
     }
+    // every pixel may look different now
+    mark_dirty(0, 0, W, H);
     redraw();
   }
 }
@@ -200,6 +337,13 @@ void SDL_UpdateRect(SDL_Surface *screen, int x, int y, int w, int h) {
   // this should always be true in NEMU-PAL
   assert(screen->flags & SDL_HWSURFACE);
 
+  // Draw what changed since the last update, and the rectangle asked
+  // for if it is smaller than the screen. The whole screen is not drawn
+  // again, since PAL asks for it after blitting every frame, and the
+  // blit has already marked the rows which changed.
+  if (w > 0 && h > 0 && (w < W || h < H)) {
+    mark_dirty(x, y, w, h);
+  }
   redraw();
 }
 
@@ -222,10 +366,46 @@ void SDL_SoftStretch(SDL_Surface *src, SDL_Rect *srcrect,
     rect.w = w;
     rect.h = h;
     SDL_BlitSurface(src, &rect, dst, dstrect);
+    return;
   }
-  else {
-    /* No other case occurs in NEMU-PAL. */
-    assert(0);
+
+  /* Scale with the nearest pixel. The position in `src' is
+   * kept in 16.16 fixed point, stepping by the ratio of the
+   * sizes of the two rectangles. */
+  int dx = dstrect->x, dy = dstrect->y;
+  int dw = dstrect->w, dh = dstrect->h;
+  if (w <= 0 || h <= 0 || dw <= 0 || dh <= 0) return;
+  uint32_t xstep = ((uint32_t)w << 16) / dw;
+  uint32_t ystep = ((uint32_t)h << 16) / dh;
+  if(dst->w - dx < dw) { dw = dst->w - dx; }
+  if(dst->h - dy < dh) { dh = dst->h - dy; }
+  if (dw <= 0 || dh <= 0) return;
+
+  int key = (src->flags & SDL_SRCCOLORKEY ? (int)src->format->colorkey : -1);
+  uint8_t *d = &dst->pixels[dx + dy * dst->pitch];
+  uint8_t *prev = NULL;
+  int prev_sy = -1;
+  uint32_t yy = ystep >> 1;
+  for (int j = 0; j < dh; j ++, d += dst->pitch, yy += ystep) {
+    int sy = y + (yy >> 16);
+    if (sy == prev_sy && key < 0) {
+      // the same source row as the one above
+      memcpy(d, prev, dw);
+    }
+    else {
+      const uint8_t *s = &src->pixels[x + sy * src->pitch];
+      uint32_t xx = xstep >> 1;
+      for (int i = 0; i < dw; i ++, xx += xstep) {
+        uint8_t c = s[xx >> 16];
+        if (c != key) d[i] = c;
+      }
+    }
+    prev = d;
+    prev_sy = sy;
+  }
+
+  if (dst->pixels == (void *)VMEM_ADDR) {
+    mark_dirty(dx, dy, dw, dh);
   }
 }
 
@@ -240,6 +420,7 @@ SDL_Surface* SDL_CreateRGBSurface(uint32_t flags, int width, int height, int dep
   s->format->palette->colors = NULL;
 
   s->format->BitsPerPixel = depth;
+  s->format->colorkey = 0;
 
   s->flags = flags;
   s->w = width;
@@ -0,0 +1,15 @@
+#ifndef _SCHED_H_
+#define _SCHED_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <_ansi.h>
+
+int	_EXFUN(sched_yield, (void));
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* _SCHED_H_ */
@@ -102,6 +102,19 @@ _PTR	_EXFUN(_calloc_r,(struct _reent *, size_t, size_t));
 _VOID	_EXFUN(_free_r,(struct _reent *, _PTR));
 _PTR	_EXFUN(_realloc_r,(struct _reent *, _PTR, size_t));
 _VOID	_EXFUN(_mstats_r,(struct _reent *, char *));
+
+/* counters of malloc, see mallstats() */
+struct mallstats {
+  size_t heap;			/* bytes taken with sbrk */
+  size_t used;			/* bytes in allocated blocks, rounded up */
+  size_t free_small;		/* bytes of free blocks in the slabs */
+  size_t free_large;		/* bytes of free pages */
+  size_t unused;		/* bytes at the top of the heap not carved yet */
+  unsigned long nmalloc, nfree, nrealloc;
+  unsigned long nsbrk;		/* calls to sbrk which grew the heap */
+};
+int	_EXFUN(mallstats,(struct mallstats *));
+
 int	_EXFUN(_system_r,(struct _reent *, const char *));
 
 /* FIXME: 4.10.7: Multibyte character functions are missing.  */
@@ -0,0 +1,27 @@
+#ifndef	_SYS_MMAN_H
+#define	_SYS_MMAN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <_ansi.h>
+#include <sys/types.h>
+
+#define	PROT_NONE	0x0
+#define	PROT_READ	0x1	/* pages can be read */
+#define	PROT_WRITE	0x2	/* pages can be written */
+#define	PROT_EXEC	0x4	/* pages can be executed */
+
+#define	MAP_SHARED	0x01	/* share changes */
+#define	MAP_PRIVATE	0x02	/* changes are private */
+
+#define	MAP_FAILED	((void *)-1)
+
+_PTR	_EXFUN(mmap,(_PTR _addr, size_t _len, int _prot, int _flags, int _fd, off_t _offset));
+int	_EXFUN(munmap,(_PTR _addr, size_t _len));
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* _SYS_MMAN_H */
@@ -0,0 +1,86 @@
+#ifndef	_SYS_RING_H
+#define	_SYS_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <_ansi.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/* Submission and completion rings shared with Nanos-lite. Operations are
+ * queued in the submission ring and executed in order by one ring_submit(),
+ * or on timer interrupts with RING_POLL. Every operation adds its result,
+ * as the system call would return, to the completion ring. */
+
+#define	RING_READ	1
+#define	RING_WRITE	2
+#define	RING_LSEEK	3	/* `len' is whence */
+#define	RING_PREAD	4
+#define	RING_PWRITE	5
+#define	RING_BLIT	6	/* write rectangles to /dev/fbctl, `fd' is ignored */
+
+#define	RING_POLL	0x1	/* the kernel also drains the ring on timer interrupts */
+
+typedef struct {
+  uint32_t op;
+  int32_t fd;
+  uint32_t addr;
+  uint32_t len;
+  int32_t offset;
+  uint32_t data;	/* passed to the completion as is */
+} RingSqe;
+
+typedef struct {
+  uint32_t data;
+  int32_t res;
+} RingCqe;
+
+typedef struct {
+  volatile uint32_t sq_head, sq_tail;
+  volatile uint32_t cq_head, cq_tail;
+  uint32_t sq_size, cq_size;	/* powers of 2 */
+  uint32_t flags;
+  RingSqe *sq;
+  RingCqe *cq;
+} Ring;
+
+/* Allocate rings of `entries' (a power of 2) and register them. */
+int	_EXFUN(ring_init,(Ring *_ring, unsigned _entries, unsigned _flags));
+void	_EXFUN(ring_exit,(Ring *_ring));
+/* Execute the queued operations, and return the number executed. */
+int	_EXFUN(ring_submit,(Ring *_ring));
+
+/* Queue an operation. Return -1 if the submission ring is full. */
+static inline int ring_queue(Ring *ring, int op, int fd, const void *addr, size_t len, off_t offset, uint32_t data) {
+  if (ring->sq_tail - ring->sq_head == ring->sq_size) {
+    return -1;
+  }
+  RingSqe *e = &ring->sq[ring->sq_tail & (ring->sq_size - 1)];
+  e->op = op;
+  e->fd = fd;
+  e->addr = (uint32_t)addr;
+  e->len = len;
+  e->offset = offset;
+  e->data = data;
+  // the entry must be filled before the kernel sees it
+  asm volatile("" : : : "memory");
+  ring->sq_tail ++;
+  return 0;
+}
+
+/* Take a completion. Return 0 if there is none. */
+static inline int ring_reap(Ring *ring, RingCqe *cqe) {
+  if (ring->cq_head == ring->cq_tail) {
+    return 0;
+  }
+  *cqe = ring->cq[ring->cq_head & (ring->cq_size - 1)];
+  ring->cq_head ++;
+  return 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* _SYS_RING_H */
@@ -31,6 +31,8 @@ struct timezone {
   int tz_dsttime;
 };
 
+int gettimeofday(struct timeval *tp, void *tzp);
+
 #ifdef __cplusplus
 }
 #endif
@@ -48,6 +48,8 @@ off_t   _EXFUN(lseek, (int _fildes, off_t _offset, int _whence ));
 long    _EXFUN(pathconf, (char *_path, int _name ));
 int     _EXFUN(pause, (void ));
 int     _EXFUN(pipe, (int _fildes[2] ));
+ssize_t _EXFUN(pread, (int _fildes, void *_buf, size_t _nbyte, off_t _offset ));
+ssize_t _EXFUN(pwrite, (int _fildes, const void *_buf, size_t _nbyte, off_t _offset ));
 int     _EXFUN(read, (int _fildes, void *_buf, size_t _nbyte ));
 int     _EXFUN(rmdir, (char *_path ));
 void *  _EXFUN(sbrk,  (size_t incr));
@@ -57,6 +57,7 @@ Supporting OS subroutines required: <<close>>, <<fstat>>, <<isatty>>,
 
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
 #include "local.h"
 
 size_t
@@ -69,7 +70,7 @@ _DEFUN (fread, (buf, size, count, fp),
   register size_t resid;
   register char *p;
   register int r;
-  size_t total;
+  size_t total, n;
 
   if ((resid = count * size) == 0)
     return 0;
@@ -84,6 +85,28 @@ _DEFUN (fread, (buf, size, count, fp),
       /* fp->_r = 0 ... done in __srefill */
       p += r;
       resid -= r;
+      if (fp->_bf._base != NULL && resid >= fp->_bf._size && !HASUB (fp)
+	  && (fp->_flags & (__SRD | __SEOF | __SLBF | __SNBF)) == __SRD)
+	{
+	  /*
+	   * The buffer is empty and at least a buffer full is wanted:
+	   * read whole buffers straight into the caller's memory, and
+	   * leave only the tail to go through the buffer.
+	   */
+	  fp->_p = fp->_bf._base;
+	  fp->_r = 0;
+	  n = resid - resid % fp->_bf._size;
+	  if (n > INT_MAX)
+	    n = INT_MAX;
+	  if ((r = (*fp->_read) (fp->_cookie, p, (int) n)) <= 0)
+	    {
+	      fp->_flags |= (r == 0) ? __SEOF : __SERR;
+	      return (total - resid) / size;
+	    }
+	  p += r;
+	  resid -= r;
+	  continue;
+	}
       if (__srefill (fp))
 	{
 	  /* no more input: return partial result */
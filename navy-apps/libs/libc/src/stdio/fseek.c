@@ -165,7 +165,9 @@ fseek (fp, offset, whence)
 
   /*
    * Can only optimise if:
-   *	reading (and not reading-and-writing);
+   *	reading (and not writing; a read-and-write stream which is
+   *	reading is fine, __swsetup() moves the file offset back
+   *	before it switches to writing);
    *	not unbuffered; and
    *	this is a `regular' Unix file (and hence seekfn==__sseek).
    * We must check __NBF first, because it is possible to have __NBF
@@ -174,7 +176,7 @@ fseek (fp, offset, whence)
 
   if (fp->_bf._base == NULL)
     __smakebuf (fp);
-  if (fp->_flags & (__SWR | __SRW | __SNBF | __SNPT))
+  if (fp->_flags & (__SWR | __SNBF | __SNPT))
     goto dumb;
   if ((fp->_flags & __SOPT) == 0)
     {
@@ -264,29 +266,18 @@ fseek (fp, offset, whence)
     }
 
   /*
-   * The place we want to get to is not within the current buffer,
-   * but we can still be kind to the kernel copyout mechanism.
-   * By aligning the file offset to a block boundary, we can let
-   * the kernel use the VM hardware to map pages instead of
-   * copying bytes laboriously.  Using a block boundary also
-   * ensures that we only read one block, rather than two.
+   * The place we want to get to is not within the current buffer.
+   * Only move the file offset: the next read refills the buffer from
+   * there, or goes around it if it wants more than a buffer full.
    */
 
-  curoff = target & ~(fp->_blksize - 1);
-  if ((*seekfn) (fp->_cookie, curoff, SEEK_SET) == POS_ERR)
+  if ((*seekfn) (fp->_cookie, target, SEEK_SET) == POS_ERR)
     goto dumb;
+  fp->_p = fp->_bf._base;
   fp->_r = 0;
   if (HASUB (fp))
     FREEUB (fp);
   fp->_flags &= ~__SEOF;
-  n = target - curoff;
-  if (n)
-    {
-      if (__srefill (fp) || fp->_r < n)
-	goto dumb;
-      fp->_p += n;
-      fp->_r -= n;
-    }
   return 0;
 
   /*
@@ -19,6 +19,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
 #include "local.h"
 #include "fvwrite.h"
 
@@ -65,12 +66,12 @@ __sfvwrite (fp, uio)
   if (fp->_flags & __SNBF)
     {
       /*
-       * Unbuffered: write up to BUFSIZ bytes at a time.
+       * Unbuffered: write each region in one go.
        */
       do
 	{
 	  GETIOV (;);
-	  w = (*fp->_write) (fp->_cookie, p, MIN (len, BUFSIZ));
+	  w = (*fp->_write) (fp->_cookie, p, MIN (len, INT_MAX));
 	  if (w <= 0)
 	    goto err;
 	  p += w;
@@ -83,7 +84,8 @@ __sfvwrite (fp, uio)
       /*
        * Fully buffered: fill partially full buffer, if any,
        * and then flush.  If there is no partial buffer, write
-       * one _bf._size byte chunk directly (without copying).
+       * as many whole _bf._size byte chunks as there are
+       * directly (without copying), in one call.
        *
        * String output is a special case: write as many bytes
        * as fit, but pretend we wrote everything.  This makes
@@ -116,6 +118,8 @@ __sfvwrite (fp, uio)
 	  else if (len >= (w = fp->_bf._size))
 	    {
 	      /* write directly */
+	      w = MIN (len, INT_MAX);
+	      w -= w % fp->_bf._size;
 	      w = (*fp->_write) (fp->_cookie, p, w);
 	      if (w <= 0)
 		goto err;
@@ -164,6 +168,7 @@ __sfvwrite (fp, uio)
 	    }
 	  else if (s >= (w = fp->_bf._size))
 	    {
+	      w = s - s % fp->_bf._size;
 	      w = (*fp->_write) (fp->_cookie, p, w);
 	      if (w <= 0)
 		goto err;
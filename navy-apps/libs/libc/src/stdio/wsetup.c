@@ -45,6 +45,14 @@ _DEFUN (__swsetup, (fp),
 	return EOF;
       if (fp->_flags & __SRD)
 	{
+	  /*
+	   * The file offset is past the input left in the buffer, which
+	   * fseek() may have kept; move it back to where reading stopped.
+	   */
+	  int unread = HASUB (fp) ? fp->_ur : fp->_r;
+	  if (unread > 0 && fp->_seek != NULL
+	      && (*fp->_seek) (fp->_cookie, (fpos_t) -unread, SEEK_CUR) == -1)
+	    return EOF;
 	  /* clobber any ungetc data */
 	  if (HASUB (fp))
 	    FREEUB (fp);
@@ -95,6 +95,10 @@ The alternate functions <<_malloc_r>>, <<_realloc_r>>, and <<_free_r>>
 are reentrant versions.  The extra argument <[reent]> is a pointer to
 a reentrancy structure.
 
+<<mallstats>> fills a <<struct mallstats>> with the size of the heap,
+the bytes in use and free, and the number of calls made so far. It
+returns <<-1>> if the allocator does not keep these counters.
+
 RETURNS
 <<malloc>> returns a pointer to the newly allocated space, if
 successful; otherwise it returns <<NULL>>.  If your application needs
@@ -7,6 +7,10 @@ typedef _PTR mptr;		/* a generic pointer, eg: (void *) */
 /* #define rcheck */
 #define MSTATS
 
+/* Allocate with the size-class slabs in slabr.c instead of the
+   power-of-two lists in mallocr.c. */
+#define MALLOC_SLAB
+
 /*
  * INT32 may be ugly, but we need to specify exactly this, and INT32 gets
  * the point across real quick.
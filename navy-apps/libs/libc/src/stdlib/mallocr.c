@@ -68,7 +68,19 @@ _DEFUN (_realloc_r, (ptr, ap, nbytes),
   return realloc (ap, nbytes);
 }
 
-#else
+#ifndef _REENT_ONLY
+
+int
+_DEFUN (mallstats, (s),
+	struct mallstats *s)
+{
+  memset (s, 0, sizeof (*s));
+  return -1;			/* the counters are not known */
+}
+
+#endif
+
+#elif !defined (MALLOC_SLAB)
 
 #ifdef MSTATS
 #include <stdio.h>
@@ -80,6 +92,8 @@ _DEFUN (_realloc_r, (ptr, ap, nbytes),
 
 extern char etext;		/* end of the program */
 
+static struct mallstats stats;
+
 
 /*      The overhead on a block is a pointer, rounded up to meet alignment
  *  requirements.  When free, it will contain a pointer to the next free block,
@@ -143,7 +157,11 @@ _DEFUN (_morecore_r, (ptr, nu),	/* ask system for more memory */
 
   /* Round up */
   if ((((size_t) cp) & ROUND_TO) != 0)
-    _sbrk_r (ptr, (ROUND_TO+1) - (((size_t) cp) & ROUND_TO));
+    {
+      siz = (ROUND_TO+1) - (((size_t) cp) & ROUND_TO);
+      if (_sbrk_r (ptr, siz) != (void *) -1)
+	stats.heap += siz;
+    }
 
   /* take 2k unless the block is bigger than that */
   rnu = (nu <= CHUNK_POWER - 3) ? CHUNK_POWER : nu + 3;
@@ -154,6 +172,8 @@ _DEFUN (_morecore_r, (ptr, nu),	/* ask system for more memory */
   /* FIXME: We assume sign extension here if sizeof(size_t) < sizeof(char *) */
   if ((cp = (mptr) _sbrk_r (ptr, 1 << rnu)) == (mptr) -1)
     return;			/* no more room! */
+  stats.heap += 1 << rnu;
+  stats.nsbrk++;
 
   /* Work out the rounding so that it will work whatever the size
      of the pointer, regardless of the size of size_t. */
@@ -203,6 +223,7 @@ _DEFUN (_malloc_r, (ptr, nbytes),
   ptr->_nextf[nunits] = *(mptr *) (ptr->_nextf[nunits]);
   p[0] = 0xff;
   p[1] = nunits;
+  stats.nmalloc++;
 
 #ifdef MSTATS
   ptr->_nmalloc[nunits]++;
@@ -256,6 +277,7 @@ _DEFUN (_free_r, (ptr, aptr),
   si = ap[1];
   *((mptr *) ap) = ptr->_nextf[si];
   ptr->_nextf[si] = (mptr) ap;
+  stats.nfree++;
 
 #ifdef MSTATS
   ptr->_nmalloc[si]--;
@@ -275,6 +297,7 @@ _DEFUN (_realloc_r, (ptr, ap, nbytes),
 
   if (ap == NULL)
     return (_malloc_r (ptr, nbytes));
+  stats.nrealloc++;
 #ifdef rcheck
   p = (char*)ap - ALIGN (8);
   if (p[1] < 13)
@@ -292,6 +315,40 @@ _DEFUN (_realloc_r, (ptr, ap, nbytes),
   return (res);
 }
 
+#ifndef _REENT_ONLY
+
+/* Free blocks are only kept on the lists of their sizes, so all of them
+   are counted in free_small. The blocks in use are only known with
+   MSTATS; otherwise they are the rest of the heap. */
+
+int
+_DEFUN (mallstats, (s),
+	struct mallstats *s)
+{
+  struct _reent *ptr = _REENT;
+  register int i;
+  register mptr p;
+
+  *s = stats;
+  s->free_small = 0;
+  for (i = 0; i < _N_LISTS; i++)
+    for (p = ptr->_nextf[i]; p; p = *(mptr *) p)
+      s->free_small += 1 << (i + 3);
+
+#ifdef MSTATS
+  s->used = 0;
+  for (i = 0; i < _N_LISTS; i++)
+    s->used += ptr->_nmalloc[i] * (1 << (i + 3));
+  /* what is left was lost to alignment */
+  s->unused = s->heap - s->used - s->free_small;
+#else
+  s->used = s->heap - s->free_small;
+#endif
+  return 0;
+}
+
+#endif
+
 #ifdef MSTATS
 
 /* ****************************************************************
@@ -332,5 +389,5 @@ _DEFUN (_mstats_r, (ptr, s),
 
 #endif /* ! defined (MSTATS) */
 
-#endif /* ! defined (MALLOC_PROVIDED) */
+#endif /* ! defined (MALLOC_PROVIDED) && ! defined (MALLOC_SLAB) */
 
@@ -0,0 +1,475 @@
+/* doc in malloc.c */
+/*
+ *  A size-class slab allocator.
+ *
+ *  Blocks up to SMALL_MAX bytes are taken from slabs: pages cut into
+ *  blocks of one size class, which are kept on a free list per class, so
+ *  malloc() and free() of a small block are a list pop and a list push.
+ *  Larger blocks get a run of whole pages.  Every slab and every run
+ *  starts at a page boundary with a page header, so free() finds what a
+ *  block is by rounding its address down to the page.
+ *
+ *  The heap grows with sbrk in chunks of ARENA_CHUNK bytes instead of one
+ *  system call per slab.  Free runs are kept on lists by their number of
+ *  pages, are split when a shorter run is wanted and are merged with the
+ *  free runs next to them when freed.  A run freed at the top of the heap
+ *  goes back to it, which lets realloc() grow the last run in place.
+ *
+ *  Compiled instead of mallocr.c when MALLOC_SLAB is defined in malloc.h.
+ */
+
+#include <_ansi.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <reent.h>
+#include <unistd.h>
+#include "malloc.h"
+
+#if !defined (MALLOC_PROVIDED) && defined (MALLOC_SLAB)
+
+#ifdef MSTATS
+#include <stdio.h>
+#endif	/* MSTATS */
+
+#define PAGE_SIZE	4096
+#define ARENA_CHUNK	(64 * 1024)
+#define NR_RUN_LISTS	32	/* runs of 1 .. 30 pages, and longer ones */
+
+#define SLAB_MAGIC	0x51ab
+#define RUN_MAGIC	0x7e11
+#define FREE_MAGIC	0xf7ee
+#define FENCE_MAGIC	0xfe9c
+
+/*  The pages of the heap are a sequence of slabs and runs up to arena_cur,
+ *  each starting with a page_hdr.  A free run also has a pointer to its
+ *  header in its last word, which the run after it follows to merge with
+ *  it.  No two free runs are next to each other, and the one before
+ *  arena_cur is never free.
+ */
+typedef struct page_hdr {
+  unsigned short magic;
+  unsigned short prev_free;	/* the run before this one is free */
+  unsigned int n;		/* size class of a slab, pages of a run */
+  struct page_hdr *next, *prev;	/* the free list of a free run */
+} page_hdr;
+
+#define PAGE_HDR	((sizeof (page_hdr) + 7) & ~7)	/* keeps blocks 8-byte aligned */
+#define PAGE_OF(p)	((page_hdr *) ((size_t) (p) & ~(PAGE_SIZE - 1)))
+#define RUN_END(h)	((char *) (h) + (h)->n * PAGE_SIZE)
+#define RUN_LIST(n)	((n) < NR_RUN_LISTS - 1 ? (n) : NR_RUN_LISTS - 1)
+
+/* The top page of the arena is kept spare, for a fence if another arena
+   has to be started.  */
+#define ROOM()		(arena_end - arena_cur > PAGE_SIZE \
+			 ? (size_t) (arena_end - arena_cur) - PAGE_SIZE : 0)
+
+/* The sizes are chosen so that the blocks of a class fill the
+   PAGE_SIZE - PAGE_HDR bytes of a slab with little left over.  */
+static const unsigned short class_size[] = {
+  8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256,
+  320, 384, 448, 504, 576, 680, 816, 1016, 1360, 2040,
+};
+#define NR_CLASSES	(sizeof (class_size) / sizeof (class_size[0]))
+#define SMALL_MAX	2040
+
+static unsigned char size_class[SMALL_MAX / 8 + 1];	/* by (size + 7) / 8 */
+static int classes_ready = 0;
+static mptr free_block[NR_CLASSES];
+static unsigned int nblock[NR_CLASSES], nused[NR_CLASSES];
+
+static page_hdr *free_run[NR_RUN_LISTS];
+static size_t run_used = 0, run_free = 0;	/* in bytes */
+static char *arena_cur = NULL, *arena_end = NULL;
+
+static struct mallstats stats;
+
+static void
+_DEFUN_VOID (init_classes)
+{
+  int i, c = 0;
+
+  for (i = 0; i <= SMALL_MAX / 8; i++)
+    {
+      while (class_size[c] < i * 8)
+	c++;
+      size_class[i] = c;
+    }
+  classes_ready = 1;
+}
+
+static void
+_DEFUN (push_run, (h),
+	page_hdr *h)
+{
+  page_hdr **list = &free_run[RUN_LIST (h->n)];
+
+  h->magic = FREE_MAGIC;
+  h->prev = NULL;
+  h->next = *list;
+  if (*list != NULL)
+    (*list)->prev = h;
+  *list = h;
+  ((page_hdr **) RUN_END (h))[-1] = h;
+  ((page_hdr *) RUN_END (h))->prev_free = 1;
+  run_free += h->n * PAGE_SIZE;
+}
+
+static void
+_DEFUN (unlink_run, (h),
+	page_hdr *h)
+{
+  if (h->prev != NULL)
+    h->prev->next = h->next;
+  else
+    free_run[RUN_LIST (h->n)] = h->next;
+  if (h->next != NULL)
+    h->next->prev = h->prev;
+  run_free -= h->n * PAGE_SIZE;
+}
+
+/* Give back the run h, merging it with the free runs around it.  */
+
+static void
+_DEFUN (free_pages, (h),
+	page_hdr *h)
+{
+  page_hdr *next = (page_hdr *) RUN_END (h);
+
+  if ((char *) next != arena_cur && next->magic == FREE_MAGIC)
+    {
+      unlink_run (next);
+      next->magic = 0;
+      h->n += next->n;
+    }
+  if (h->prev_free)
+    {
+      page_hdr *prev = ((page_hdr **) h)[-1];
+      unlink_run (prev);
+      h->magic = 0;
+      prev->n += h->n;
+      h = prev;
+    }
+
+  if (RUN_END (h) == arena_cur)
+    {
+      h->magic = 0;
+      arena_cur = (char *) h;
+    }
+  else
+    push_run (h);
+}
+
+/* Make room for at least nbytes at the top of the heap.  */
+
+static int
+_DEFUN (_morecore_r, (ptr, nbytes),
+	struct _reent *ptr _AND
+	size_t nbytes)
+{
+  char *brk = (char *) _sbrk_r (ptr, 0);
+  size_t incr;
+
+  if (brk != arena_end)
+    {
+      /* The break was moved by somebody else.  The rest of the old arena
+	 becomes a fence, which is never freed, and a new arena starts at
+	 the next page.  */
+      if (arena_end != NULL)
+	{
+	  page_hdr *h = (page_hdr *) arena_cur;
+	  h->magic = FENCE_MAGIC;
+	  h->prev_free = 0;
+	  h->n = (arena_end - arena_cur) / PAGE_SIZE;
+	}
+      incr = (PAGE_SIZE - ((size_t) brk & (PAGE_SIZE - 1))) & (PAGE_SIZE - 1);
+      if (_sbrk_r (ptr, incr + PAGE_SIZE) == (void *) -1)
+	return 0;
+      stats.heap += incr + PAGE_SIZE;
+      arena_cur = brk + incr;
+      arena_end = arena_cur + PAGE_SIZE;
+    }
+
+  if (ROOM () >= nbytes)
+    return 1;
+  incr = nbytes - ROOM ();
+  incr = (incr + ARENA_CHUNK - 1) & ~(ARENA_CHUNK - 1);
+  if (_sbrk_r (ptr, incr) == (void *) -1)
+    return 0;
+  arena_end += incr;
+  stats.heap += incr;
+  stats.nsbrk++;
+  return 1;
+}
+
+/* Take a run of npages pages, from the free lists if there is a long
+   enough run, otherwise from the top of the heap.  */
+
+static page_hdr *
+_DEFUN (_alloc_pages_r, (ptr, npages),
+	struct _reent *ptr _AND
+	size_t npages)
+{
+  page_hdr *h;
+  size_t i;
+
+  for (i = npages; i < NR_RUN_LISTS - 1; i++)
+    if ((h = free_run[i]) != NULL)
+      goto found;
+  for (h = free_run[NR_RUN_LISTS - 1]; h != NULL; h = h->next)
+    if (h->n >= npages)
+      goto found;
+
+  if (ROOM () < npages * PAGE_SIZE && !_morecore_r (ptr, npages * PAGE_SIZE))
+    return NULL;
+  h = (page_hdr *) arena_cur;
+  h->prev_free = 0;
+  h->n = npages;
+  arena_cur += npages * PAGE_SIZE;
+  return h;
+
+found:
+  unlink_run (h);
+  ((page_hdr *) RUN_END (h))->prev_free = 0;
+  if (h->n > npages)
+    {
+      page_hdr *rest = (page_hdr *) ((char *) h + npages * PAGE_SIZE);
+      rest->prev_free = 0;
+      rest->n = h->n - npages;
+      push_run (rest);
+      h->n = npages;
+    }
+  return h;
+}
+
+/* Cut a new slab into free blocks of class c.  */
+
+static int
+_DEFUN (_refill_r, (ptr, c),
+	struct _reent *ptr _AND
+	int c)
+{
+  size_t size = class_size[c];
+  int i, n = (PAGE_SIZE - PAGE_HDR) / size;
+  page_hdr *h;
+  char *base;
+
+  if ((h = _alloc_pages_r (ptr, 1)) == NULL)
+    return 0;
+  base = (char *) h + PAGE_HDR;
+  h->magic = SLAB_MAGIC;
+  h->n = c;
+  for (i = n - 1; i >= 0; i--)
+    {
+      *(mptr *) (base + i * size) = free_block[c];
+      free_block[c] = base + i * size;
+    }
+  nblock[c] += n;
+  return 1;
+}
+
+_PTR
+_DEFUN (_malloc_r, (ptr, nbytes),
+	struct _reent * ptr _AND
+	size_t nbytes)		/* get a block */
+{
+  page_hdr *h;
+  mptr p;
+  size_t npages;
+  int c;
+
+  if (nbytes <= SMALL_MAX)
+    {
+      if (!classes_ready)
+	init_classes ();
+      c = size_class[(nbytes + 7) >> 3];
+      if (free_block[c] == NULL && !_refill_r (ptr, c))
+	return NULL;
+      p = free_block[c];
+      free_block[c] = *(mptr *) p;
+      nused[c]++;
+      stats.nmalloc++;
+      return p;
+    }
+
+  if (nbytes > (size_t) -1 - PAGE_HDR - PAGE_SIZE)
+    return NULL;
+  npages = (nbytes + PAGE_HDR + PAGE_SIZE - 1) / PAGE_SIZE;
+  if ((h = _alloc_pages_r (ptr, npages)) == NULL)
+    return NULL;
+  h->magic = RUN_MAGIC;
+  run_used += npages * PAGE_SIZE;
+  stats.nmalloc++;
+  return (char *) h + PAGE_HDR;
+}
+
+void
+_DEFUN (_free_r, (ptr, aptr),
+	struct _reent *ptr _AND
+	_PTR aptr)
+{
+  page_hdr *h;
+  int c;
+
+  if (aptr == NULL)
+    return;
+
+  h = PAGE_OF (aptr);
+  if (h->magic == SLAB_MAGIC)
+    {
+      c = h->n;
+      *(mptr *) aptr = free_block[c];
+      free_block[c] = aptr;
+      nused[c]--;
+    }
+  else if (h->magic == RUN_MAGIC && (char *) aptr == (char *) h + PAGE_HDR)
+    {
+      run_used -= h->n * PAGE_SIZE;
+      free_pages (h);
+    }
+  else
+    return;			/* not a block in use */
+
+  stats.nfree++;
+}
+
+_PTR
+_DEFUN (_realloc_r, (ptr, ap, nbytes),
+	struct _reent * ptr _AND
+	_PTR ap _AND
+	size_t nbytes)
+{
+  page_hdr *h, *next;
+  size_t onb, npages;
+  char *res;
+
+  if (ap == NULL)
+    return (_malloc_r (ptr, nbytes));
+  if (nbytes == 0)
+    {
+      _free_r (ptr, ap);
+      return (NULL);
+    }
+
+  stats.nrealloc++;
+  h = PAGE_OF (ap);
+  if (h->magic == SLAB_MAGIC)
+    {
+      onb = class_size[h->n];
+      if (nbytes <= onb && nbytes > onb / 2)
+	return (ap);
+    }
+  else if (h->magic == RUN_MAGIC)
+    {
+      onb = h->n * PAGE_SIZE - PAGE_HDR;
+      npages = (nbytes + PAGE_HDR + PAGE_SIZE - 1) / PAGE_SIZE;
+      if (nbytes > SMALL_MAX)
+	{
+	  next = (page_hdr *) RUN_END (h);
+	  if ((char *) next == arena_cur && npages > h->n)
+	    {
+	      /* the run is at the top of the heap, so grow it in place */
+	      size_t more = (npages - h->n) * PAGE_SIZE;
+	      if (ROOM () < more
+		  && !(_morecore_r (ptr, more) && (char *) next == arena_cur))
+		goto move;
+	      arena_cur += more;
+	      run_used += more;
+	      h->n = npages;
+	      return (ap);
+	    }
+	  if ((char *) next != arena_cur && next->magic == FREE_MAGIC
+	      && h->n + next->n >= npages)
+	    {
+	      /* take the free run after it */
+	      unlink_run (next);
+	      ((page_hdr *) RUN_END (next))->prev_free = 0;
+	      run_used += next->n * PAGE_SIZE;
+	      h->n += next->n;
+	      next->magic = 0;
+	    }
+	  if (npages <= h->n)
+	    {
+	      /* give the pages at the end back */
+	      if (npages < h->n)
+		{
+		  page_hdr *rest = (page_hdr *) ((char *) h + npages * PAGE_SIZE);
+		  rest->prev_free = 0;
+		  rest->n = h->n - npages;
+		  h->n = npages;
+		  run_used -= rest->n * PAGE_SIZE;
+		  free_pages (rest);
+		}
+	      return (ap);
+	    }
+	}
+    }
+  else
+    return (NULL);
+
+move:
+  if ((res = _malloc_r (ptr, nbytes)) == NULL)
+    return (NULL);
+  memcpy (res, ap, (nbytes < onb) ? nbytes : onb);
+  _free_r (ptr, ap);
+  return (res);
+}
+
+#ifndef _REENT_ONLY
+
+int
+_DEFUN (mallstats, (s),
+	struct mallstats *s)
+{
+  int c;
+
+  *s = stats;
+  s->used = run_used;
+  s->free_small = 0;
+  for (c = 0; c < NR_CLASSES; c++)
+    {
+      s->used += nused[c] * class_size[c];
+      s->free_small += (nblock[c] - nused[c]) * class_size[c];
+    }
+  s->free_large = run_free;
+  s->unused = arena_end - arena_cur;
+  return 0;
+}
+
+#endif
+
+#ifdef MSTATS
+
+/* ****************************************************************
+ * mstats - print out statistics about malloc
+ *
+ * Prints one line for each size class with the number of blocks in use
+ * and free, then the totals of the heap.
+ */
+
+void
+_DEFUN (_mstats_r, (ptr, s),
+	struct _reent *ptr _AND
+	char *s)
+{
+  struct mallstats st;
+  int c;
+
+  fprintf (_stderr_r (ptr), "Memory allocation statistics %s\n", s);
+  for (c = 0; c < NR_CLASSES; c++)
+    if (nblock[c] != 0)
+      fprintf (_stderr_r (ptr), "%6d:\tused %u\tfree %u\n", class_size[c],
+	       nused[c], nblock[c] - nused[c]);
+
+  mallstats (&st);
+  fprintf (_stderr_r (ptr), "\theap %lu, used %lu, free %lu + %lu, unused %lu\n",
+	   (unsigned long) st.heap, (unsigned long) st.used,
+	   (unsigned long) st.free_small, (unsigned long) st.free_large,
+	   (unsigned long) st.unused);
+  fprintf (_stderr_r (ptr), "\tmalloc %lu, free %lu, realloc %lu, sbrk %lu\n",
+	   st.nmalloc, st.nfree, st.nrealloc, st.nsbrk);
+}
+
+#endif /* ! defined (MSTATS) */
+
+#endif /* ! defined (MALLOC_PROVIDED) && defined (MALLOC_SLAB) */
@@ -43,6 +43,10 @@ int NDL_OpenDisplay(int w, int h);
 int NDL_CloseDisplay();
 int NDL_DrawRect(uint32_t *pixels, int x, int y, int w, int h);
 int NDL_Render();
+// Draw `pixels', which has `stride' pixels per row, to (x, y) of the canvas
+// on the screen at once. The canvas is bypassed when the kernel supports it,
+// or is the frame buffer itself when it covers the whole screen.
+int NDL_UpdateRect(uint32_t *pixels, int x, int y, int w, int h, int stride);
 int NDL_WaitEvent(NDL_Event *event);
 int NDL_LoadBitmap(NDL_Bitmap *bmp, const char *filename);
 int NDL_ReleaseBitmap(NDL_Bitmap *bmp);
@@ -3,11 +3,41 @@
 #include <assert.h>
 #include <string.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#ifndef __ISA_NATIVE__
+#include <sys/ring.h>
+#endif
 
 static int has_nwm = 0;
 static uint32_t *canvas;
 static FILE *fbdev, *evtdev;
 
+// a rectangle written to /dev/fbctl, which is drawn in one system call
+typedef struct {
+  int32_t x, y, w, h;
+  int32_t stride;
+  const uint32_t *pixels;
+} FbRect;
+static int fbctl = -1;
+
+// the canvas is /dev/fb mapped into memory if it covers the whole screen
+static int fb_mapped = 0;
+
+// /dev/events_bin returns NDL_Event records, many in one read
+static int evtfd = -1;
+static NDL_Event evtbuf[16];
+static int nr_evt = 0, evt_idx = 0;
+
+#ifndef __ISA_NATIVE__
+// Drawing a frame and reading the events which came meanwhile are
+// submitted together in one system call.
+static Ring ring;
+static int has_ring = 0;
+enum { RING_DATA_DRAW, RING_DATA_EVENTS };
+#endif
+
 static void get_display_info();
 static int canvas_w, canvas_h, screen_w, screen_h, pad_x, pad_y;
 
@@ -37,14 +67,45 @@ int NDL_OpenDisplay(int w, int h) {
     pad_x = (screen_w - canvas_w) / 2;
     pad_y = (screen_h - canvas_h) / 2;
     fbdev = fopen("/dev/fb", "w"); assert(fbdev);
-    evtdev = fopen("/dev/events", "r"); assert(evtdev);
+    fbctl = open("/dev/fbctl", O_WRONLY);
+    if (canvas_w == screen_w && canvas_h == screen_h) {
+      int fd = open("/dev/fb", O_RDWR);
+      void *fb = mmap(NULL, sizeof(uint32_t) * w * h, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      close(fd);
+      if (fb != MAP_FAILED) {
+        free(canvas);
+        canvas = fb;
+        fb_mapped = 1;
+      }
+    }
+    evtfd = open("/dev/events_bin", O_RDONLY);
+    if (evtfd < 0) {
+      // the text format is kept for older kernels
+      evtdev = fopen("/dev/events", "r"); assert(evtdev);
+    }
+#ifndef __ISA_NATIVE__
+    if (fbctl >= 0 && !has_ring) {
+      has_ring = (ring_init(&ring, 4, 0) == 0);
+    }
+#endif
   }
 }
 
 int NDL_CloseDisplay() {
   if (canvas) {
-    free(canvas);
+    if (fb_mapped) {
+      munmap(canvas, sizeof(uint32_t) * canvas_w * canvas_h);
+      fb_mapped = 0;
+    } else {
+      free(canvas);
+    }
+  }
+#ifndef __ISA_NATIVE__
+  if (has_ring) {
+    ring_exit(&ring);
+    has_ring = 0;
   }
+#endif
   return 0;
 }
 
@@ -67,9 +128,52 @@ int NDL_DrawRect(uint32_t *pixels, int x, int y, int w, int h) {
   }
 }
 
+static void fbctl_draw(const uint32_t *pixels, int x, int y, int w, int h, int stride) {
+  FbRect r = { .x = x + pad_x, .y = y + pad_y, .w = w, .h = h, .stride = stride, .pixels = pixels };
+#ifndef __ISA_NATIVE__
+  if (has_ring) {
+    ring_queue(&ring, RING_BLIT, fbctl, &r, sizeof(r), 0, RING_DATA_DRAW);
+    if (evtfd >= 0 && evt_idx == nr_evt) {
+      ring_queue(&ring, RING_READ, evtfd, evtbuf, sizeof(evtbuf), 0, RING_DATA_EVENTS);
+    }
+    ring_submit(&ring);
+
+    RingCqe c;
+    while (ring_reap(&ring, &c)) {
+      if (c.data == RING_DATA_EVENTS && c.res > 0) {
+        nr_evt = c.res / sizeof(evtbuf[0]);
+        evt_idx = 0;
+      }
+    }
+    return;
+  }
+#endif
+  write(fbctl, &r, sizeof(r));
+}
+
+int NDL_UpdateRect(uint32_t *pixels, int x, int y, int w, int h, int stride) {
+  if (fbctl >= 0 && !fb_mapped) {
+    fbctl_draw(pixels, x, y, w, h, stride);
+    return 0;
+  }
+
+  for (int i = 0; i < h; i ++) {
+    NDL_DrawRect(pixels + i * stride, x, y + i, w, 1);
+  }
+  NDL_Render();
+  return 0;
+}
+
 int NDL_Render() {
   if (has_nwm) {
     fflush(stdout);
+  } else if (fb_mapped) {
+    // the pixels are already in the frame buffer, only flush it
+    if (fbctl >= 0) {
+      write(fbctl, NULL, 0);
+    }
+  } else if (fbctl >= 0) {
+    fbctl_draw(canvas, 0, 0, canvas_w, canvas_h, canvas_w);
   } else {
     for (int i = 0; i < canvas_h; i ++) {
       fseek(fbdev, ((i + pad_y) * screen_w + pad_x) * sizeof(uint32_t), SEEK_SET);
@@ -88,7 +192,22 @@ static const char *keys[] = {
 
 #define numkeys ( sizeof(keys) / sizeof(keys[0]) )
 
+static int wait_event_bin(NDL_Event *event) {
+  while (evt_idx == nr_evt) {
+    int n = read(evtfd, evtbuf, sizeof(evtbuf));
+    assert(n >= 0);
+    nr_evt = n / sizeof(evtbuf[0]);
+    evt_idx = 0;
+  }
+  *event = evtbuf[evt_idx ++];
+  return 0;
+}
+
 int NDL_WaitEvent(NDL_Event *event) {
+  if (evtfd >= 0) {
+    return wait_event_bin(event);
+  }
+
   char buf[256], *p = buf, ch;
 
   while (1) {
@@ -2,8 +2,15 @@
 #include <stdint.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#include <sys/mman.h>
+#include <sys/ring.h>
+#include <sys/times.h>
+#include <sched.h>
 #include <assert.h>
 #include <time.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
 #include "syscall.h"
 
 // TODO: discuss with syscall interface
@@ -11,9 +18,17 @@
 
 // FIXME: this is temporary
 
+// sysenter enters the kernel without looking up the IDT. It takes the same
+// arguments and returns the same way as `int $0x80'.
 int _syscall_(int type, uintptr_t a0, uintptr_t a1, uintptr_t a2){
   int ret = -1;
-  asm volatile("int $0x80": "=a"(ret): "a"(type), "b"(a0), "c"(a1), "d"(a2));
+  asm volatile("sysenter": "=a"(ret): "a"(type), "b"(a0), "c"(a1), "d"(a2));
+  return ret;
+}
+
+static int _syscall4_(int type, uintptr_t a0, uintptr_t a1, uintptr_t a2, uintptr_t a3){
+  int ret = -1;
+  asm volatile("sysenter": "=a"(ret): "a"(type), "b"(a0), "c"(a1), "d"(a2), "S"(a3));
   return ret;
 }
 
@@ -23,24 +38,39 @@ void _exit(int status) {
 
 int _open(const char *path, int flags, mode_t mode) {
   // _exit(SYS_open);
-  return _syscall_(SYS_open, (uintptr_t)path, flags, mode);
+  int fd = _syscall_(SYS_open, (uintptr_t)path, flags, mode);
+  if (fd < 0) {
+    errno = ENOENT;
+    return -1;
+  }
+  return fd;
 }
 
 int _write(int fd, void *buf, size_t count){
   return _syscall_(SYS_write, fd, (uintptr_t)buf, count);
 }
 
+// The break in the kernel is moved in batches of SBRK_BATCH bytes, and is
+// kept ahead of the break seen by malloc(), so most calls do not trap.
+// It is only moved back when more than two batches are unused.
+#define SBRK_BATCH (16 * 4096)
+
 void *_sbrk(intptr_t increment){
   extern int end;
   static uintptr_t probreak = (uintptr_t)&end;
+  static uintptr_t kbreak = (uintptr_t)&end;
   uintptr_t probreak_new = probreak + increment;
-  int r = _syscall_(SYS_brk, probreak_new, 0, 0);
-  if(r == 0) {
-    uintptr_t temp = probreak;
-    probreak = probreak_new;
-    return (void*)temp;
+  if (probreak_new > kbreak || probreak_new + 2 * SBRK_BATCH < kbreak) {
+    uintptr_t kbreak_new = (probreak_new + SBRK_BATCH - 1) & ~(SBRK_BATCH - 1);
+    int r = _syscall_(SYS_brk, kbreak_new, 0, 0);
+    if (r != 0) {
+      return (void *)-1;
+    }
+    kbreak = kbreak_new;
   }
-  return (void *)-1;
+  uintptr_t temp = probreak;
+  probreak = probreak_new;
+  return (void*)temp;
 }
 
 int _read(int fd, void *buf, size_t count) {
@@ -58,14 +88,77 @@ off_t _lseek(int fd, off_t offset, int whence) {
   return _syscall_(SYS_lseek, fd, offset, whence);
 }
 
-// The code below is not used by Nanos-lite.
-// But to pass linking, they are defined as dummy functions
+// positioned I/O, the offset of the file is not changed
+ssize_t pread(int fd, void *buf, size_t count, off_t offset) {
+  return _syscall4_(SYS_pread, fd, (uintptr_t)buf, count, offset);
+}
+
+ssize_t pwrite(int fd, const void *buf, size_t count, off_t offset) {
+  return _syscall4_(SYS_pwrite, fd, (uintptr_t)buf, count, offset);
+}
+
+// Regular files are mapped read-only, in place if they are in ramdisk
+// uncompressed, and /dev/fb can be mapped for writing with MAP_SHARED. `addr' is just a hint and is
+// ignored.
+void *mmap(void *addr, size_t length, int prot, int flags, int fd, off_t offset) {
+  if ((prot & ~(PROT_READ | PROT_WRITE)) || !(flags & (MAP_SHARED | MAP_PRIVATE)) ||
+      ((prot & PROT_WRITE) && !(flags & MAP_SHARED))) {
+    errno = EINVAL;
+    return MAP_FAILED;
+  }
+  int ret = _syscall4_(SYS_mmap, length, prot, fd, offset);
+  if (ret == -1) {
+    errno = EACCES;
+    return MAP_FAILED;
+  }
+  return (void *)ret;
+}
+
+int munmap(void *addr, size_t length) {
+  int ret = _syscall_(SYS_munmap, (uintptr_t)addr, length, 0);
+  if (ret < 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  return 0;
+}
 
-// not implement but used
+// Nanos-lite only reports the size of a file.
+// The standard streams are character devices, so that they are line buffered.
 int _fstat(int fd, struct stat *buf) {
+  int size = _syscall_(SYS_fstat, fd, 0, 0);
+  if (size < 0) {
+    errno = EBADF;
+    return -1;
+  }
+  memset(buf, 0, sizeof(*buf));
+  buf->st_mode = (fd <= 2 ? _IFCHR : _IFREG) | 0666;
+  buf->st_size = size;
+  buf->st_nlink = 1;
   return 0;
 }
 
+// Give up the CPU to the next process.
+int sched_yield(void) {
+  return _syscall_(SYS_yield, 0, 0, 0);
+}
+
+// The CPU time of the process is reported as user time, in milliseconds.
+clock_t _times(struct tms *buf) {
+  return _syscall_(SYS_times, (uintptr_t)buf, 0, 0);
+}
+
+int _gettimeofday(struct timeval *tv, void *tz) {
+  return _syscall_(SYS_gettimeofday, (uintptr_t)tv, 0, 0);
+}
+
+int gettimeofday(struct timeval *tv, void *tz) {
+  return _gettimeofday(tv, tz);
+}
+
+// The code below is not used by Nanos-lite.
+// But to pass linking, they are defined as dummy functions
+
 int execve(const char *fname, char * const argv[], char *const envp[]) {
   assert(0);
   return -1;
@@ -85,6 +178,35 @@ pid_t _getpid() {
   return 1;
 }
 
+int ring_init(Ring *ring, unsigned entries, unsigned flags) {
+  if (entries == 0 || (entries & (entries - 1)) != 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  memset(ring, 0, sizeof(*ring));
+  ring->sq_size = ring->cq_size = entries;
+  ring->flags = flags;
+  ring->sq = malloc(sizeof(RingSqe) * entries);
+  ring->cq = malloc(sizeof(RingCqe) * entries);
+  if (ring->sq == NULL || ring->cq == NULL || _syscall_(SYS_ring_setup, (uintptr_t)ring, 0, 0) != 0) {
+    free(ring->sq);
+    free(ring->cq);
+    errno = ENOSYS;
+    return -1;
+  }
+  return 0;
+}
+
+void ring_exit(Ring *ring) {
+  _syscall_(SYS_ring_setup, 0, 0, 0);
+  free(ring->sq);
+  free(ring->cq);
+}
+
+int ring_submit(Ring *ring) {
+  return _syscall_(SYS_ring_enter, 0, 0, 0);
+}
+
 char **environ;
 
 time_t time(time_t *tloc) {
@@ -117,17 +239,6 @@ pid_t _wait(int *status) {
   return -1;
 }
 
-clock_t _times(void *buf) {
-  assert(0);
-  return 0;
-}
-
-int _gettimeofday(struct timeval *tv) {
-  assert(0);
-  tv->tv_sec = 0;
-  tv->tv_usec = 0;
-  return 0;
-}
 
 int _fcntl(int fd, int cmd, ... ) {
   assert(0);
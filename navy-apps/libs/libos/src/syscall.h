@@ -21,7 +21,17 @@ enum {
   SYS_unlink,
   SYS_wait,
   SYS_times,
-  SYS_gettimeofday
+  SYS_gettimeofday,
+  SYS_pread,
+  SYS_pwrite,
+  SYS_mmap,
+  SYS_munmap,
+  SYS_yield,
+  SYS_ring_setup,
+  SYS_ring_enter
 };
 
+// enter the kernel directly, returning what the system call returns
+int _syscall_(int type, uintptr_t a0, uintptr_t a1, uintptr_t a2);
+
 #endif
@@ -0,0 +1,24 @@
+#include <stdio.h>
+#include <time.h>
+#include <sched.h>
+
+#define BENCH_NAME "ctxsw"
+#include <bench.h>
+
+/* Measure the latency of sched_yield(). When another process is runnable,
+ * every call is a context switch through the kernel and back. */
+
+#define N 20000
+
+int main() {
+  clock_t cpu_start = clock();
+  long start = bench_now_us();
+  for (int i = 0; i < N; i ++) {
+    sched_yield();
+  }
+  long us = bench_now_us() - start;
+
+  long cpu_ms = (clock() - cpu_start) * 1000 / CLOCKS_PER_SEC;
+  bench_report_ops("yield", N, us, " cpu_ms=%ld", cpu_ms);
+  return 0;
+}
@@ -0,0 +1,57 @@
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <sys/time.h>
+
+/* Timing and reporting shared by the benchmarks. Each of them defines
+ * BENCH_NAME before including this file, and prints every result as one
+ * line of the form
+ *
+ *   <BENCH_NAME>: name=<case> key=value ...
+ *
+ * so that the output of all of them is parsed the same way. */
+
+#ifndef BENCH_NAME
+#error "define BENCH_NAME before including bench.h"
+#endif
+
+static inline long bench_now_us() {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+// nanoseconds per operation, without overflowing 32 bits in between
+static inline long bench_ns_per_op(long us, long n) {
+  return us / n * 1000 + us % n * 1000 / n;
+}
+
+// kilobytes per second, as if it took at least one millisecond
+static inline long bench_kb_per_s(long bytes, long us) {
+  long ms = (us < 1000 ? 1 : us / 1000);
+  return bytes / 1024 * 1000 / ms;
+}
+
+/* Report `n' operations done in `us' microseconds. More keys are printed
+ * with `fmt' if it is not NULL, which should start with a space. */
+static inline void bench_report_ops(const char *name, long n, long us, const char *fmt, ...) {
+  printf(BENCH_NAME ": name=%s iters=%ld us=%ld ns_per_op=%ld",
+      name, n, us, bench_ns_per_op(us, n));
+  if (fmt != NULL) {
+    va_list ap;
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+  }
+  printf("\n");
+}
+
+// report `bytes' transferred in `us' microseconds
+static inline void bench_report_bytes(const char *name, long bytes, long us) {
+  printf(BENCH_NAME ": name=%s bytes=%ld us=%ld kb_per_s=%ld\n",
+      name, bytes, us, bench_kb_per_s(bytes, us));
+}
+
+#endif
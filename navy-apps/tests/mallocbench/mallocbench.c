@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_NAME "mallocbench"
+#include <bench.h>
+
+/* Measure malloc() with the allocation patterns of the applications:
+ * small objects churned like Lua tables and strings, buffers grown with
+ * realloc(), and frame-sized surfaces. Then the heap is summarized with
+ * mallstats() in a line named `heap'. */
+
+#define NR_SLOTS 1024
+
+static void *slot[NR_SLOTS];
+static unsigned int seed = 1;
+
+static unsigned int rnd() {
+  seed = seed * 1103515245 + 12345;
+  return seed >> 8;
+}
+
+static void free_all() {
+  for (int i = 0; i < NR_SLOTS; i ++) {
+    free(slot[i]);
+    slot[i] = NULL;
+  }
+}
+
+static void bench_small(int i) {
+  int k = rnd() % NR_SLOTS;
+  if (slot[k]) {
+    free(slot[k]);
+    slot[k] = NULL;
+  } else {
+    slot[k] = malloc(8 + rnd() % 120);
+  }
+}
+
+static void bench_grow(int i) {
+  int k = rnd() % 64;
+  size_t size = 16 << (rnd() % 12);
+  slot[k] = realloc(slot[k], size);
+  memset(slot[k], 0, 16);
+}
+
+static void bench_surface(int i) {
+  int k = rnd() % 8;
+  free(slot[k]);
+  slot[k] = malloc((32 + rnd() % 288) * (32 + rnd() % 208));
+}
+
+static void run(const char *name, void (*fn)(int), int n) {
+  long start = bench_now_us();
+  for (int i = 0; i < n; i ++) {
+    fn(i);
+  }
+  long us = bench_now_us() - start;
+  free_all();
+
+  bench_report_ops(name, n, us, NULL);
+}
+
+int main() {
+  run("small", bench_small, 100000);
+  run("grow", bench_grow, 10000);
+  run("surface", bench_surface, 2000);
+
+  struct mallstats st;
+  if (mallstats(&st) != 0) {
+    return 0;
+  }
+  printf(BENCH_NAME ": name=heap heap=%lu used=%lu free_small=%lu free_large=%lu unused=%lu "
+      "malloc=%lu free=%lu realloc=%lu sbrk=%lu\n",
+      (unsigned long)st.heap, (unsigned long)st.used, (unsigned long)st.free_small,
+      (unsigned long)st.free_large, (unsigned long)st.unused,
+      st.nmalloc, st.nfree, st.nrealloc, st.nsbrk);
+  return 0;
+}
@@ -0,0 +1,45 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define BENCH_NAME "rdbench"
+#include <bench.h>
+
+/* Measure the throughput of reading a file from ramdisk, in order and at
+ * random offsets, with read() of BLOCK_SIZE bytes. */
+
+#define FILE_NAME "/share/games/pal/map.mkf"
+#define BLOCK_SIZE 4096
+#define NR_RANDOM 1024
+
+static char buf[BLOCK_SIZE];
+
+int main() {
+  int fd = open(FILE_NAME, O_RDONLY);
+  if (fd < 0) {
+    printf("rdbench: can not open %s\n", FILE_NAME);
+    return 1;
+  }
+  off_t size = lseek(fd, 0, SEEK_END);
+
+  lseek(fd, 0, SEEK_SET);
+  long bytes = 0, start = bench_now_us();
+  int n;
+  while ((n = read(fd, buf, BLOCK_SIZE)) > 0) {
+    bytes += n;
+  }
+  bench_report_bytes("sequential", bytes, bench_now_us() - start);
+
+  srand(1);
+  bytes = 0;
+  start = bench_now_us();
+  for (int i = 0; i < NR_RANDOM; i ++) {
+    lseek(fd, (off_t)(rand() % (size / BLOCK_SIZE)) * BLOCK_SIZE, SEEK_SET);
+    bytes += read(fd, buf, BLOCK_SIZE);
+  }
+  bench_report_bytes("random", bytes, bench_now_us() - start);
+
+  close(fd);
+  return 0;
+}
@@ -0,0 +1,55 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BENCH_NAME "stdiobench"
+#include <bench.h>
+
+/* Measure the throughput of streaming a file through stdio with fread()
+ * of different sizes, and the cost of short fseek()s within the buffer,
+ * as PAL does when it reads the index of an MKF file. */
+
+#define FILE_NAME "/share/games/pal/map.mkf"
+#define MAX_CHUNK (256 * 1024)
+#define NR_SEEK 10000
+
+static char buf[MAX_CHUNK];
+
+static void stream(FILE *fp, size_t chunk) {
+  fseek(fp, 0, SEEK_SET);
+  long bytes = 0, start = bench_now_us();
+  size_t n;
+  while ((n = fread(buf, 1, chunk, fp)) > 0) {
+    bytes += n;
+  }
+  long us = bench_now_us() - start;
+
+  char name[32];
+  sprintf(name, "fread_%d", (int)chunk);
+  bench_report_bytes(name, bytes, us);
+}
+
+static void seek_in_buffer(FILE *fp) {
+  long start = bench_now_us();
+  for (int i = 0; i < NR_SEEK; i ++) {
+    fseek(fp, (i * 4) % 512, SEEK_SET);
+    getc(fp);
+  }
+  bench_report_ops("fseek_getc", NR_SEEK, bench_now_us() - start, NULL);
+}
+
+int main() {
+  FILE *fp = fopen(FILE_NAME, "r");
+  if (fp == NULL) {
+    printf("stdiobench: can not open %s\n", FILE_NAME);
+    return 1;
+  }
+
+  stream(fp, 256);
+  stream(fp, 4096);
+  stream(fp, 64 * 1024);
+  stream(fp, MAX_CHUNK);
+  seek_in_buffer(fp);
+
+  fclose(fp);
+  return 0;
+}
@@ -0,0 +1,166 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <ndl.h>
+#include <syscall.h>
+
+#define BENCH_NAME "sysbench"
+#include <bench.h>
+
+/* Measure the cost of the system calls and device paths which the
+ * applications use most. Each case also reports instr_per_op, the number
+ * of retired instructions read from /proc/perfcnt, or -1 if the kernel
+ * does not provide it. */
+
+#define FILE_NAME "/share/games/pal/map.mkf"
+
+static int perfcnt = -1;
+static int file = -1;
+static off_t file_size;
+static char buf[64 * 1024];
+
+static uint64_t now_instr() {
+  uint64_t instr = 0;
+  if (perfcnt >= 0) {
+    // the number of retired instructions is the first field of _PerfCnt
+    pread(perfcnt, &instr, sizeof(instr), 0);
+  }
+  return instr;
+}
+
+static void bench_null(int i) {
+  _syscall_(SYS_none, 0, 0, 0);
+}
+
+static void bench_read1(int i) {
+  if (read(file, buf, 1) != 1) {
+    lseek(file, 0, SEEK_SET);
+  }
+}
+
+static void bench_read64k(int i) {
+  if (read(file, buf, sizeof(buf)) != sizeof(buf)) {
+    lseek(file, 0, SEEK_SET);
+  }
+}
+
+static void bench_lseek(int i) {
+  lseek(file, (i * 512) % file_size, SEEK_SET);
+}
+
+static int events = -1;
+static void bench_events(int i) {
+  read(events, buf, 64);
+}
+
+static uint32_t *frame;
+static int screen_w, screen_h;
+static int fb = -1;
+static void bench_fb_write(int i) {
+  pwrite(fb, frame, sizeof(uint32_t) * screen_w * screen_h, 0);
+}
+
+// a canvas of the whole screen is /dev/fb mapped into memory
+static void bench_frame_mapped(int i) {
+  NDL_DrawRect(frame, 0, 0, screen_w, screen_h);
+  NDL_Render();
+}
+
+/* sbrk() only traps once in a batch of pages, so the break is moved with
+ * SYS_brk directly, one page further each time. It starts well above the
+ * break of the kernel which libos keeps, so malloc() is not disturbed. */
+static uintptr_t brk_base;
+static void bench_brk(int i) {
+  _syscall_(SYS_brk, brk_base + (i + 1) * 4096, 0, 0);
+}
+
+// `a / b' without the 64-bit division of libgcc, which is not linked
+static uint64_t div64(uint64_t a, uint32_t b) {
+  uint64_t q = 0, r = 0;
+  for (int i = 63; i >= 0; i --) {
+    r = (r << 1) | ((a >> i) & 1);
+    if (r >= b) {
+      r -= b;
+      q |= (uint64_t)1 << i;
+    }
+  }
+  return q;
+}
+
+static void run(const char *name, void (*fn)(int), int n) {
+  long start = bench_now_us();
+  uint64_t instr_start = now_instr();
+  for (int i = 0; i < n; i ++) {
+    fn(i);
+  }
+  uint64_t instr = now_instr() - instr_start;
+  long us = bench_now_us() - start;
+
+  long instr_per_op = (perfcnt >= 0 ? (long)div64(instr, n) : -1);
+  bench_report_ops(name, n, us, " instr_per_op=%ld", instr_per_op);
+}
+
+static void get_screen_size() {
+  FILE *fp = fopen("/proc/dispinfo", "r");
+  if (!fp) return;
+  char line[128];
+  while (fgets(line, sizeof(line), fp)) {
+    sscanf(line, "WIDTH : %d", &screen_w);
+    sscanf(line, "HEIGHT : %d", &screen_h);
+  }
+  fclose(fp);
+}
+
+int main() {
+  perfcnt = open("/proc/perfcnt", O_RDONLY);
+
+  run("null_syscall", bench_null, 10000);
+
+  file = open(FILE_NAME, O_RDONLY);
+  if (file >= 0) {
+    file_size = lseek(file, 0, SEEK_END);
+    lseek(file, 0, SEEK_SET);
+    run("read_1b", bench_read1, 10000);
+    lseek(file, 0, SEEK_SET);
+    run("read_64k", bench_read64k, 64);
+    run("lseek", bench_lseek, 10000);
+    close(file);
+  } else {
+    printf("sysbench: can not open %s\n", FILE_NAME);
+  }
+
+  events = open("/dev/events", O_RDONLY);
+  if (events >= 0) {
+    run("events", bench_events, 1000);
+    close(events);
+  }
+
+  get_screen_size();
+  if (screen_w > 0 && screen_h > 0) {
+    frame = malloc(sizeof(uint32_t) * screen_w * screen_h);
+    memset(frame, 0x5a, sizeof(uint32_t) * screen_w * screen_h);
+    fb = open("/dev/fb", O_WRONLY);
+    if (fb >= 0) {
+      run("fb_write", bench_fb_write, 32);
+      close(fb);
+    }
+    NDL_OpenDisplay(screen_w, screen_h);
+    run("frame_mapped", bench_frame_mapped, 32);
+    NDL_CloseDisplay();
+    free(frame);
+  }
+
+  brk_base = ((uintptr_t)sbrk(0) + 4096 - 1) / 4096 * 4096 + 256 * 1024;
+  if (_syscall_(SYS_brk, brk_base, 0, 0) == 0) {
+    run("brk_4k", bench_brk, 256);
+    _syscall_(SYS_brk, brk_base, 0, 0);
+  }
+
+  if (perfcnt >= 0) {
+    close(perfcnt);
+  }
+  return 0;
+}
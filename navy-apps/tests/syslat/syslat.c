@@ -0,0 +1,37 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <syscall.h>
+
+#define BENCH_NAME "syslat"
+#include <bench.h>
+
+/* Measure the latency of an empty system call (SYS_none) entered with
+ * `int $0x80' and with sysenter. */
+
+#define N 50000
+
+static int sys_none_int() {
+  int ret;
+  asm volatile("int $0x80": "=a"(ret): "a"(SYS_none), "b"(0), "c"(0), "d"(0));
+  return ret;
+}
+
+static int sys_none_sysenter() {
+  int ret;
+  asm volatile("sysenter": "=a"(ret): "a"(SYS_none), "b"(0), "c"(0), "d"(0));
+  return ret;
+}
+
+static void bench(const char *name, int (*syscall)()) {
+  long start = bench_now_us();
+  for (int i = 0; i < N; i ++) {
+    syscall();
+  }
+  bench_report_ops(name, N, bench_now_us() - start, NULL);
+}
+
+int main() {
+  bench("int80", sys_none_int);
+  bench("sysenter", sys_none_sysenter);
+  return 0;
+}
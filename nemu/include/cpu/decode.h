@@ -2,6 +2,7 @@
 #define __CPU_DECODE_H__
 
 #include "common.h"
+#include <setjmp.h>
 
 #include "rtl.h"
 
@@ -29,6 +30,10 @@ typedef struct {
   uint8_t ext_opcode;
   bool is_jmp;
   vaddr_t jmp_eip;
+  bool is_lock;     // executing under the `lock' prefix
+  bool lock_fail;   // the locked memory update lost a race and must be retried
+  jmp_buf *fault_env;        // where to go on a page fault, NULL if faults are fatal
+  uint32_t fault_error_code;
   Operand src, dest, src2;
 #ifdef DEBUG
   char assembly[80];
@@ -64,8 +69,8 @@ void read_ModR_M(vaddr_t *, Operand *, bool, Operand *, bool);
 
 void operand_write(Operand *, rtlreg_t *);
 
-/* shared by all helper functions */
-extern DecodeInfo decoding;
+/* shared by all helper functions of the same vCPU */
+extern __thread DecodeInfo decoding;
 
 #define id_src (&decoding.src)
 #define id_src2 (&decoding.src2)
@@ -83,6 +88,7 @@ make_DHelper(I_E2G);
 make_DHelper(I_G2E);
 make_DHelper(I);
 make_DHelper(r);
+make_DHelper(a2r);
 make_DHelper(E);
 make_DHelper(gp7_E);
 make_DHelper(test_I);
@@ -95,6 +101,8 @@ make_DHelper(mov_I2E);
 make_DHelper(mov_G2E);
 make_DHelper(mov_E2G);
 make_DHelper(lea_M2G);
+make_DHelper(mov_load_cr);
+make_DHelper(mov_store_cr);
 
 make_DHelper(gp2_1_E);
 make_DHelper(gp2_cl2E);
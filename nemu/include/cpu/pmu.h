@@ -0,0 +1,24 @@
+#ifndef __PMU_H__
+#define __PMU_H__
+
+#include "common.h"
+
+/* Performance counters of a vCPU. They count guest events only, so the
+ * readings do not depend on how fast the host is.
+ */
+typedef struct {
+  uint64_t instr;      // retired instructions
+  uint64_t load;       // data loads
+  uint64_t store;      // data stores
+  uint64_t mmio;       // memory-mapped I/O accesses
+  uint64_t branch;     // taken branches
+  uint64_t exception;  // interrupts and exceptions delivered
+} PMU_state;
+
+enum { PMU_INSTR, PMU_LOAD, PMU_STORE, PMU_MMIO, PMU_BRANCH, PMU_EXCEPTION, PMU_TSC, NR_PMU_CNT };
+
+extern __thread PMU_state pmu;
+
+uint64_t get_tsc(void);
+
+#endif
@@ -2,6 +2,8 @@
 #define __REG_H__
 
 #include "common.h"
+#include "memory/mmu.h"
+#include <stddef.h>
 
 enum { R_EAX, R_ECX, R_EDX, R_EBX, R_ESP, R_EBP, R_ESI, R_EDI };
 enum { R_AX, R_CX, R_DX, R_BX, R_SP, R_BP, R_SI, R_DI };
@@ -58,10 +60,36 @@ typedef struct {
   rtlreg_t es; // 配x64
   rtlreg_t ds;
 
+  CR0 cr0;
+  vaddr_t cr2;
+  CR3 cr3;
+
+  vaddr_t sysenter_eip;  // IA32_SYSENTER_EIP, the entry of sysenter
+
+  // the pending interrupt lines, set by devices; it must stay the last
+  // member, see cpu_rollback()
+  uint32_t INTR;
+
 } CPU_state;
 
 
-extern CPU_state cpu;
+#define NR_CPU_MAX 8
+
+/* Every vCPU runs on its own host thread. `cpu' is the state of the vCPU
+ * executing on the calling thread, and `cpus[]' lets the monitor reach all
+ * of them. vCPU 0 runs on the main thread together with the monitor.
+ */
+extern __thread CPU_state cpu;
+extern __thread int cpu_id;
+extern CPU_state *cpus[NR_CPU_MAX];
+extern int nr_cpu;
+
+/* Roll the calling vCPU back to `snapshot' to execute an instruction
+ * again. INTR is not restored, since devices and other vCPUs set it at
+ * any time, and a line raised meanwhile must not be lost. */
+static inline void cpu_rollback(const CPU_state *snapshot) {
+  memcpy(&cpu, snapshot, offsetof(CPU_state, INTR));
+}
 
 static inline int check_reg_index(int index) {
   assert(index >= 0 && index < 8);
@@ -2,8 +2,9 @@
 #define __RTL_H__
 
 #include "nemu.h"
+#include "cpu/pmu.h"
 
-extern rtlreg_t t0, t1, t2, t3;
+extern __thread rtlreg_t t0, t1, t2, t3;
 extern const rtlreg_t tzero;
 
 /* RTL basic instructions */
@@ -61,10 +62,12 @@ static inline void rtl_idiv(rtlreg_t* q, rtlreg_t* r, const rtlreg_t* src1_hi, c
 
 static inline void rtl_lm(rtlreg_t *dest, const rtlreg_t* addr, int len) {
   *dest = vaddr_read(*addr, len);
+  pmu.load ++;
 }
 
 static inline void rtl_sm(rtlreg_t* addr, int len, const rtlreg_t* src1) {
   vaddr_write(*addr, len, *src1);
+  pmu.store ++;
 }
 
 static inline void rtl_lr_b(rtlreg_t* dest, int r) {
@@ -7,6 +7,8 @@ typedef void(*mmio_callback_t)(paddr_t, int, bool);
 
 void* add_mmio_map(paddr_t, int, mmio_callback_t);
 int is_mmio(paddr_t);
+int mmio_range(paddr_t, size_t);
+void* mmio_host_addr(paddr_t, int);
 
 uint32_t mmio_read(paddr_t, int, int);
 void mmio_write(paddr_t, int, uint32_t, int);
@@ -15,4 +15,12 @@ uint32_t paddr_read(paddr_t, int);
 void vaddr_write(vaddr_t, int, uint32_t);
 void paddr_write(paddr_t, int, uint32_t);
 
+void* paddr_host_range(paddr_t, size_t);
+
+/* atomic with respect to other vCPUs, used by `xchg' and the `lock' prefix */
+uint32_t vaddr_xchg(vaddr_t, int, uint32_t);
+uint32_t paddr_xchg(paddr_t, int, uint32_t);
+bool vaddr_cmpxchg(vaddr_t, int, uint32_t, uint32_t);
+bool paddr_cmpxchg(paddr_t, int, uint32_t, uint32_t);
+
 #endif
@@ -1,9 +1,9 @@
 #include "cpu/exec.h"
 #include "cpu/rtl.h"
 
-/* shared by all helper functions */
-DecodeInfo decoding;
-rtlreg_t t0, t1, t2, t3;
+/* shared by all helper functions of the same vCPU */
+__thread DecodeInfo decoding;
+__thread rtlreg_t t0, t1, t2, t3;
 const rtlreg_t tzero = 0;
 
 #define make_DopHelper(name) void concat(decode_op_, name) (vaddr_t *eip, Operand *op, bool load_val)
@@ -132,6 +132,16 @@ make_DHelper(mov_E2G) {
   decode_op_rm(eip, id_src, true, id_dest, false);
 }
 
+/* the general register is always in the r/m field,
+ * and the reg field gives the control register */
+make_DHelper(mov_load_cr) {
+  decode_op_rm(eip, id_dest, false, id_src, false);
+}
+
+make_DHelper(mov_store_cr) {
+  decode_op_rm(eip, id_src, true, id_dest, false);
+}
+
 make_DHelper(lea_M2G) {
   decode_op_rm(eip, id_src, false, id_dest, false);
 }
@@ -187,6 +197,12 @@ make_DHelper(r) {
   decode_op_r(eip, id_dest, true);
 }
 
+/* eXX <- eAX, used by xchg */
+make_DHelper(a2r) {
+  decode_op_r(eip, id_dest, true);
+  decode_op_a(eip, id_src, true);
+}
+
 make_DHelper(E) {
   decode_op_rm(eip, id_dest, true, NULL, false);
 }
@@ -310,6 +326,14 @@ make_DHelper(out_a2dx) {
 
 void operand_write(Operand *op, rtlreg_t* src) {
   if (op->type == OP_TYPE_REG) { rtl_sr(op->reg, op->width, src); }
-  else if (op->type == OP_TYPE_MEM) { rtl_sm(&op->addr, op->width, src); }
+  else if (op->type == OP_TYPE_MEM) {
+    if (decoding.is_lock) {
+      /* Commit only if the memory still holds the value read at decode time.
+       * Otherwise another vCPU got in between, and the instruction is retried. */
+      if (!vaddr_cmpxchg(op->addr, op->width, op->val, *src)) { decoding.lock_fail = true; }
+      else { pmu.store ++; }
+    }
+    else { rtl_sm(&op->addr, op->width, src); }
+  }
   else { assert(0); }
 }
\ No newline at end of file
@@ -4,10 +4,12 @@
 make_EHelper(nop);
 make_EHelper(inv);
 make_EHelper(nemu_trap);
+make_EHelper(nemu_hypercall);
 
 // prefix.c
 make_EHelper(real);
 make_EHelper(operand_size);
+make_EHelper(lock);
 
 // data-mov.c
 make_EHelper(mov);
@@ -18,9 +20,12 @@ make_EHelper(popa);
 make_EHelper(leave);
 make_EHelper(cltd);
 make_EHelper(cwtl);
+make_EHelper(pushf);
+make_EHelper(popf);
 make_EHelper(movsx);
 make_EHelper(movzx);
 make_EHelper(lea);
+make_EHelper(xchg);
 
 // control.c
 make_EHelper(jmp);
@@ -34,6 +39,7 @@ make_EHelper(call_rm);
 make_EHelper(add);
 make_EHelper(sub);
 make_EHelper(cmp);
+make_EHelper(cmpxchg);
 make_EHelper(inc);
 make_EHelper(dec);
 make_EHelper(neg);
@@ -66,5 +72,10 @@ make_EHelper(mov_r2cr);
 make_EHelper(mov_cr2r);
 make_EHelper(int);
 make_EHelper(iret);
+make_EHelper(sysenter);
+make_EHelper(wrmsr);
+make_EHelper(rdtsc);
+make_EHelper(cli);
+make_EHelper(sti);
 make_EHelper(in);
 make_EHelper(out);
\ No newline at end of file
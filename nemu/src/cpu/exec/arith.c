@@ -62,6 +62,31 @@ make_EHelper(cmp) {
   print_asm_template2(cmp);
 }
 
+make_EHelper(cmpxchg) {
+  rtl_lr(&t3, R_EAX, id_dest->width);
+  rtl_sub(&t2, &t3, &id_dest->val);
+  rtl_update_ZFSF(&t2, id_dest->width);
+  rtl_sltu(&t0, &t3, &id_dest->val);
+  rtl_set_CF(&t0);
+  rtl_xor(&t0, &t3, &id_dest->val);
+  rtl_xor(&t1, &t3, &t2);
+  rtl_and(&t0, &t0, &t1);
+  rtl_msb(&t0, &t0, id_dest->width);
+  rtl_set_OF(&t0);
+
+  rtl_get_ZF(&t0);
+  if (t0) {
+    operand_write(id_dest, &id_src->val);
+  }
+  else {
+    /* the destination is written back unchanged, as the i386 manual says */
+    operand_write(id_dest, &id_dest->val);
+    rtl_sr(R_EAX, id_dest->width, &id_dest->val);
+  }
+
+  print_asm_template2(cmpxchg);
+}
+
 make_EHelper(inc) {
   rtl_addi(&t2, &id_dest->val, 1);
   operand_write(id_dest, &t2);
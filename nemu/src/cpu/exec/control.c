@@ -3,6 +3,7 @@
 make_EHelper(jmp) {
   // the target address is calculated at the decode stage
   decoding.is_jmp = 1;
+  pmu.branch ++;
 
   print_asm("jmp %x", decoding.jmp_eip);
 }
@@ -12,6 +13,7 @@ make_EHelper(jcc) {
   uint8_t subcode = decoding.opcode & 0xf;
   rtl_setcc(&t2, subcode);
   decoding.is_jmp = t2;
+  pmu.branch += t2;
 
   print_asm("j%s %x", get_cc_name(subcode), decoding.jmp_eip);
 }
@@ -19,6 +21,7 @@ make_EHelper(jcc) {
 make_EHelper(jmp_rm) {
   decoding.jmp_eip = id_dest->val;
   decoding.is_jmp = 1;
+  pmu.branch ++;
 
   print_asm("jmp *%s", id_dest->str);
 }
@@ -28,6 +31,7 @@ make_EHelper(call) {
   rtl_li(&t2, decoding.seq_eip);
   rtl_push(&t2);
   decoding.is_jmp = 1;
+  pmu.branch ++;
 
   print_asm("call %x", decoding.jmp_eip);
 }
@@ -36,6 +40,7 @@ make_EHelper(ret) {
   rtl_pop(&t2);
   decoding.jmp_eip = t2;
   decoding.is_jmp = 1;
+  pmu.branch ++;
 
   print_asm("ret");
 }
@@ -45,6 +50,7 @@ make_EHelper(call_rm) {
   rtl_push(&t2);
   decoding.jmp_eip = id_dest->val;
   decoding.is_jmp = 1;
+  pmu.branch ++;
 
   print_asm("call *%s", id_dest->str);
 }
\ No newline at end of file
@@ -46,6 +46,21 @@ make_EHelper(popa) {
   print_asm("popa");
 }
 
+make_EHelper(pushf) {
+  t0 = 0;
+  memcpy(&t0, &cpu.eflags, sizeof(cpu.eflags));
+  rtl_push(&t0);
+
+  print_asm("pushf");
+}
+
+make_EHelper(popf) {
+  rtl_pop(&t0);
+  memcpy(&cpu.eflags, &t0, sizeof(cpu.eflags));
+
+  print_asm("popf");
+}
+
 make_EHelper(leave) {
   rtl_mv(&cpu.esp, &cpu.ebp);
   rtl_pop(&cpu.ebp);
@@ -95,4 +110,19 @@ make_EHelper(lea) {
   rtl_li(&t2, id_src->addr);
   operand_write(id_dest, &t2);
   print_asm_template2(lea);
-}
\ No newline at end of file
+}
+
+make_EHelper(xchg) {
+  if (id_dest->type == OP_TYPE_MEM) {
+    /* xchg with a memory operand is always atomic, even without `lock' */
+    rtl_li(&t2, vaddr_xchg(id_dest->addr, id_dest->width, id_src->val));
+    pmu.store ++;
+  }
+  else {
+    rtl_mv(&t2, &id_dest->val);
+    operand_write(id_dest, &id_src->val);
+  }
+  operand_write(id_src, &t2);
+
+  print_asm_template2(xchg);
+}
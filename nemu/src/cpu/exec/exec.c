@@ -105,13 +105,13 @@ opcode_entry opcode_table [512] = {
   /* 0x78 */	IDEXW(J, jcc, 1), IDEXW(J, jcc, 1), IDEXW(J, jcc, 1), IDEXW(J, jcc, 1),
   /* 0x7c */	IDEXW(J, jcc, 1), IDEXW(J, jcc, 1), IDEXW(J, jcc, 1), IDEXW(J, jcc, 1),
   /* 0x80 */	IDEXW(I2E, gp1, 1), IDEX(I2E, gp1), EMPTY, IDEX(SI2E, gp1),
-  /* 0x84 */	IDEXW(G2E, test, 1), IDEX(G2E, test), EMPTY, EMPTY,
+  /* 0x84 */	IDEXW(G2E, test, 1), IDEX(G2E, test), IDEXW(G2E, xchg, 1), IDEX(G2E, xchg),
   /* 0x88 */	IDEXW(mov_G2E, mov, 1), IDEX(mov_G2E, mov), IDEXW(mov_E2G, mov, 1), IDEX(mov_E2G, mov),
   /* 0x8c */	EMPTY, IDEX(lea_M2G, lea), EMPTY, EMPTY,
-  /* 0x90 */	EX(nop), EMPTY, EMPTY, EMPTY,
-  /* 0x94 */	EMPTY, EMPTY, EMPTY, EMPTY,
+  /* 0x90 */	EX(nop), IDEX(a2r, xchg), IDEX(a2r, xchg), IDEX(a2r, xchg),
+  /* 0x94 */	IDEX(a2r, xchg), IDEX(a2r, xchg), IDEX(a2r, xchg), IDEX(a2r, xchg),
   /* 0x98 */	EX(cwtl), EX(cltd), EMPTY, EMPTY,
-  /* 0x9c */	EMPTY, EMPTY, EMPTY, EMPTY,
+  /* 0x9c */	EX(pushf), EX(popf), EMPTY, EMPTY,
   /* 0xa0 */	IDEXW(O2a, mov, 1), IDEX(O2a, mov), IDEXW(a2O, mov, 1), IDEX(a2O, mov),
   /* 0xa4 */	EMPTY, EMPTY, EMPTY, EMPTY,
   /* 0xa8 */	IDEXW(I2a, test, 1), IDEX(I2a, test), EMPTY, EMPTY,
@@ -125,16 +125,16 @@ opcode_entry opcode_table [512] = {
   /* 0xc8 */	EMPTY, EX(leave), EMPTY, EMPTY,
   /* 0xcc */	EMPTY, IDEXW(I, int, 1), EMPTY, EX(iret),
   /* 0xd0 */	IDEXW(gp2_1_E, gp2, 1), IDEX(gp2_1_E, gp2), IDEXW(gp2_cl2E, gp2, 1), IDEX(gp2_cl2E, gp2),
-  /* 0xd4 */	EMPTY, EMPTY, EX(nemu_trap), EMPTY,
+  /* 0xd4 */	EMPTY, EMPTY, EX(nemu_trap), EX(nemu_hypercall),
   /* 0xd8 */	EMPTY, EMPTY, EMPTY, EMPTY,
   /* 0xdc */	EMPTY, EMPTY, EMPTY, EMPTY,
   /* 0xe0 */	EMPTY, EMPTY, EMPTY, IDEXW(J, jcc, 1),
   /* 0xe4 */	IDEXW(in_I2a, in, 1), IDEXW(in_I2a, in, 1), IDEXW(out_a2I, out, 1), IDEXW(out_a2I, out, 1),
   /* 0xe8 */	IDEX(J, call), IDEX(J, jmp), EMPTY, IDEXW(J, jmp, 1),
   /* 0xec */	IDEXW(in_dx2a, in, 1), IDEX(in_dx2a, in), IDEXW(out_a2dx, out, 1), IDEX(out_a2dx, out),
-  /* 0xf0 */	EMPTY, EMPTY, EMPTY, EMPTY,
+  /* 0xf0 */	EX(lock), EMPTY, EMPTY, EMPTY,
   /* 0xf4 */	EMPTY, EMPTY, IDEXW(E, gp3, 1), IDEX(E, gp3),
-  /* 0xf8 */	EMPTY, EMPTY, EMPTY, EMPTY,
+  /* 0xf8 */	EMPTY, EMPTY, EX(cli), EX(sti),
   /* 0xfc */	EMPTY, EMPTY, IDEXW(E, gp4, 1), IDEX(E, gp5),
 
   /*2 byte_opcode_table */
@@ -147,12 +147,12 @@ opcode_entry opcode_table [512] = {
   /* 0x14 */	EMPTY, EMPTY, EMPTY, EMPTY,
   /* 0x18 */	EMPTY, EMPTY, EMPTY, EMPTY,
   /* 0x1c */	EMPTY, EMPTY, EMPTY, EMPTY,
-  /* 0x20 */	EMPTY, EMPTY, EMPTY, EMPTY,
+  /* 0x20 */	IDEX(mov_load_cr, mov_cr2r), EMPTY, IDEX(mov_store_cr, mov_r2cr), EMPTY,
   /* 0x24 */	EMPTY, EMPTY, EMPTY, EMPTY,
   /* 0x28 */	EMPTY, EMPTY, EMPTY, EMPTY,
   /* 0x2c */	EMPTY, EMPTY, EMPTY, EMPTY,
-  /* 0x30 */	EMPTY, EMPTY, EMPTY, EMPTY,
-  /* 0x34 */	EMPTY, EMPTY, EMPTY, EMPTY,
+  /* 0x30 */	EX(wrmsr), EX(rdtsc), EMPTY, EMPTY,
+  /* 0x34 */	EX(sysenter), EMPTY, EMPTY, EMPTY,
   /* 0x38 */	EMPTY, EMPTY, EMPTY, EMPTY,
   /* 0x3c */	EMPTY, EMPTY, EMPTY, EMPTY,
   /* 0x40 */	EMPTY, EMPTY, EMPTY, EMPTY,
@@ -183,7 +183,7 @@ opcode_entry opcode_table [512] = {
   /* 0xa4 */	EMPTY, EMPTY, EMPTY, EMPTY,
   /* 0xa8 */	EMPTY, EMPTY, EMPTY, EMPTY,
   /* 0xac */	EMPTY, EMPTY, EMPTY, IDEX(E2G, imul2),
-  /* 0xb0 */	EMPTY, EMPTY, EMPTY, EMPTY,
+  /* 0xb0 */	IDEXW(G2E, cmpxchg, 1), IDEX(G2E, cmpxchg), EMPTY, EMPTY,
   /* 0xb4 */	EMPTY, EMPTY, IDEXW(mov_E2G, movzx, 1), IDEXW(mov_E2G, movzx, 2),
   /* 0xb8 */	EMPTY, EMPTY, EMPTY, EMPTY,
   /* 0xbc */	EMPTY, EMPTY, IDEXW(mov_E2G, movsx, 1), IDEXW(mov_E2G, movsx, 2),
@@ -223,6 +223,11 @@ static inline void update_eip(void) {
   cpu.eip = (decoding.is_jmp ? (decoding.is_jmp = 0, decoding.jmp_eip) : decoding.seq_eip);
 }
 
+void raise_page_fault(void);
+void raise_intr(uint8_t NO, vaddr_t ret_addr);
+
+#define IRQ_BASE 32   // the vector of interrupt line 0, not the standard
+
 void exec_wrapper(bool print_flag) {
 #ifdef DEBUG
   decoding.p = decoding.asm_buf;
@@ -230,7 +235,28 @@ void exec_wrapper(bool print_flag) {
 #endif
 
   decoding.seq_eip = cpu.eip;
-  exec_real(&decoding.seq_eip);
+  if (cpu.cr0.paging) {
+    /* any memory access may fault, so keep a copy to roll back to */
+    CPU_state snapshot = cpu;
+    jmp_buf env;
+    if (setjmp(env) == 0) {
+      decoding.fault_env = &env;
+      exec_real(&decoding.seq_eip);
+    }
+    else {
+      vaddr_t cr2 = cpu.cr2;
+      cpu_rollback(&snapshot);
+      cpu.cr2 = cr2;
+      decoding.is_lock = false;
+      decoding.is_operand_size_16 = false;
+      decoding.fault_env = NULL;
+      raise_page_fault();
+    }
+    decoding.fault_env = NULL;
+  }
+  else {
+    exec_real(&decoding.seq_eip);
+  }
 
 #ifdef DEBUG
   int instr_len = decoding.seq_eip - cpu.eip;
@@ -247,6 +273,15 @@ void exec_wrapper(bool print_flag) {
 #endif
 
   update_eip();
+  pmu.instr ++;
+
+  if (cpu.INTR && cpu.eflags.IF) {
+    // the lowest line is served first
+    int irq = __builtin_ctz(cpu.INTR);
+    __atomic_fetch_and(&cpu.INTR, ~(1u << irq), __ATOMIC_RELAXED);
+    raise_intr(IRQ_BASE + irq, cpu.eip);
+    update_eip();
+  }
 
 #ifdef DIFF_TEST
   void difftest_step(uint32_t);
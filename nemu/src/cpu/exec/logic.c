@@ -79,8 +79,10 @@ make_EHelper(setcc) {
 }
 
 make_EHelper(not) {
-  rtl_not(&id_dest->val);
-  operand_write(id_dest, &id_dest->val);
+  /* keep the loaded value intact for a possible `lock' prefix */
+  rtl_mv(&t2, &id_dest->val);
+  rtl_not(&t2);
+  operand_write(id_dest, &t2);
 
   print_asm_template1(not);
 }
@@ -7,3 +7,23 @@ make_EHelper(operand_size) {
   exec_real(eip);
   decoding.is_operand_size_16 = false;
 }
+
+make_EHelper(lock) {
+  /* The memory operand is updated with compare-and-swap against the value
+   * read at decode time. If another vCPU modified it in between, roll back
+   * and execute the instruction again.
+   */
+  CPU_state snapshot = cpu;
+  vaddr_t start = *eip;
+
+  decoding.is_lock = true;
+  while (1) {
+    decoding.lock_fail = false;
+    exec_real(eip);
+    if (!decoding.lock_fail) { break; }
+    cpu_rollback(&snapshot);
+    *eip = start;
+    decoding.is_jmp = false;
+  }
+  decoding.is_lock = false;
+}
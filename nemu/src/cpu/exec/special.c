@@ -44,3 +44,74 @@ make_EHelper(nemu_trap) {
   diff_test_skip_qemu();
 #endif
 }
+
+/* Bulk memory operations performed by NEMU on behalf of the guest.
+ * The hypercall number is passed in eax, and eax is set to 0 on success
+ * or -1 if an address range is invalid, in which case nothing is done and
+ * the guest should fall back to plain loads and stores.
+ * Note that this is not the standard.
+ */
+enum {
+  HC_MEMCPY = 1,  /* edi = dst, esi = src, ecx = n, the ranges may overlap */
+  HC_MEMSET,      /* edi = dst, edx = c, ecx = n */
+  HC_RECT,        /* ebx points to { dst, src, w, h, dst_pitch, src_pitch },
+                     where w and the pitches are in bytes */
+};
+
+static uint32_t hc_rect(paddr_t args) {
+  uint32_t dst = paddr_read(args, 4);
+  uint32_t src = paddr_read(args + 4, 4);
+  uint32_t w = paddr_read(args + 8, 4);
+  uint32_t h = paddr_read(args + 12, 4);
+  uint32_t dst_pitch = paddr_read(args + 16, 4);
+  uint32_t src_pitch = paddr_read(args + 20, 4);
+  if (w == 0 || h == 0) { return 0; }
+  if (dst_pitch < w || src_pitch < w) { return -1; }
+
+  uint8_t *pdst = paddr_host_range(dst, (uint64_t)dst_pitch * (h - 1) + w);
+  uint8_t *psrc = paddr_host_range(src, (uint64_t)src_pitch * (h - 1) + w);
+  if (pdst == NULL || psrc == NULL) { return -1; }
+
+  int i;
+  for (i = 0; i < h; i ++) {
+    memmove(pdst, psrc, w);
+    pdst += dst_pitch;
+    psrc += src_pitch;
+  }
+  return 0;
+}
+
+make_EHelper(nemu_hypercall) {
+  uint32_t ret = -1;
+  void *dst, *src;
+
+  switch (cpu.eax) {
+    case HC_MEMCPY:
+      if (cpu.ecx == 0) { ret = 0; break; }
+      dst = paddr_host_range(cpu.edi, cpu.ecx);
+      src = paddr_host_range(cpu.esi, cpu.ecx);
+      if (dst != NULL && src != NULL) {
+        memmove(dst, src, cpu.ecx);
+        ret = 0;
+      }
+      break;
+    case HC_MEMSET:
+      if (cpu.ecx == 0) { ret = 0; break; }
+      dst = paddr_host_range(cpu.edi, cpu.ecx);
+      if (dst != NULL) {
+        memset(dst, cpu.edx, cpu.ecx);
+        ret = 0;
+      }
+      break;
+    case HC_RECT: ret = hc_rect(cpu.ebx); break;
+    default: break;
+  }
+
+  print_asm("nemu hypercall (eax = %d) = %d", cpu.eax, ret);
+  cpu.eax = ret;
+
+#ifdef DIFF_TEST
+  extern void diff_test_skip_qemu();
+  diff_test_skip_qemu();
+#endif
+}
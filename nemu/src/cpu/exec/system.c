@@ -15,13 +15,24 @@ make_EHelper(lidt) {
 }
 
 make_EHelper(mov_r2cr) {
-  TODO();
+  switch (id_dest->reg) {
+    case 0: cpu.cr0.val = id_src->val; break;
+    case 2: cpu.cr2 = id_src->val; break;
+    case 3: cpu.cr3.val = id_src->val; break;
+    default: panic("mov to cr%d is not supported", id_dest->reg);
+  }
 
   print_asm("movl %%%s,%%cr%d", reg_name(id_src->reg, 4), id_dest->reg);
 }
 
 make_EHelper(mov_cr2r) {
-  TODO();
+  switch (id_src->reg) {
+    case 0: rtl_li(&t0, cpu.cr0.val); break;
+    case 2: rtl_li(&t0, cpu.cr2); break;
+    case 3: rtl_li(&t0, cpu.cr3.val); break;
+    default: panic("mov from cr%d is not supported", id_src->reg);
+  }
+  operand_write(id_dest, &t0);
 
   print_asm("movl %%cr%d,%%%s", id_src->reg, reg_name(id_dest->reg, 4));
 
@@ -30,6 +41,7 @@ make_EHelper(mov_cr2r) {
 #endif
 }
 extern void raise_intr(uint8_t NO, vaddr_t ret_addr);
+extern void raise_sysenter(vaddr_t ret_addr);
 
 make_EHelper(int) {
 
@@ -56,6 +68,54 @@ make_EHelper(iret) {
   print_asm("iret");
 }
 
+make_EHelper(cli) {
+  cpu.eflags.IF = 0;
+
+  print_asm("cli");
+}
+
+make_EHelper(sti) {
+  cpu.eflags.IF = 1;
+
+  print_asm("sti");
+}
+
+#define MSR_SYSENTER_EIP 0x176
+
+make_EHelper(wrmsr) {
+  switch (cpu.ecx) {
+    case MSR_SYSENTER_EIP: cpu.sysenter_eip = cpu.eax; break;
+    default: panic("wrmsr 0x%x is not supported", cpu.ecx);
+  }
+
+  print_asm("wrmsr");
+
+#ifdef DIFF_TEST
+  diff_test_skip_qemu();
+#endif
+}
+
+make_EHelper(sysenter) {
+  raise_sysenter(decoding.seq_eip);
+  print_asm("sysenter");
+
+#ifdef DIFF_TEST
+  diff_test_skip_nemu();
+#endif
+}
+
+make_EHelper(rdtsc) {
+  uint64_t tsc = get_tsc();
+  rtl_li(&cpu.eax, (uint32_t)tsc);
+  rtl_li(&cpu.edx, tsc >> 32);
+
+  print_asm("rdtsc");
+
+#ifdef DIFF_TEST
+  diff_test_skip_qemu();
+#endif
+}
+
 uint32_t pio_read(ioaddr_t, int);
 void pio_write(ioaddr_t, int, uint32_t);
 
@@ -1,17 +1,24 @@
 #include "cpu/exec.h"
 #include "memory/mmu.h"
 
-void raise_intr(uint8_t NO, vaddr_t ret_addr) {
-  /* TODO: Trigger an interrupt/exception with ``NO''.
-   * That is, use ``NO'' to index the IDT.
-   */
-
+static void push_frame(vaddr_t ret_addr) {
   memcpy(&t1, &cpu.eflags, sizeof(cpu.eflags));
   rtl_li(&t0, t1);
   rtl_push(&t0);
   rtl_push(&cpu.cs);
   rtl_li(&t0, ret_addr);
   rtl_push(&t0);
+}
+
+static void do_intr(uint8_t NO, vaddr_t ret_addr, bool has_error_code, uint32_t error_code) {
+  push_frame(ret_addr);
+  if (has_error_code) {
+    rtl_li(&t0, error_code);
+    rtl_push(&t0);
+  }
+
+  // external interrupts are not nested
+  cpu.eflags.IF = 0;
 
   vaddr_t gate_addr = cpu.idtr.base + NO * sizeof(GateDesc);
   assert(gate_addr <= cpu.idtr.base + cpu.idtr.limit);
@@ -23,7 +30,51 @@ void raise_intr(uint8_t NO, vaddr_t ret_addr) {
 
   decoding.is_jmp = 1;
   decoding.jmp_eip = target_addr;
+
+  pmu.exception ++;
+}
+
+void raise_intr(uint8_t NO, vaddr_t ret_addr) {
+  /* TODO: Trigger an interrupt/exception with ``NO''.
+   * That is, use ``NO'' to index the IDT.
+   */
+
+  do_intr(NO, ret_addr, false, 0);
+}
+
+/* There are no privilege levels in NEMU, so sysenter does not switch the
+ * stack. It pushes the same frame as `int', which is returned with iret,
+ * but jumps to IA32_SYSENTER_EIP directly instead of looking up the IDT. */
+void raise_sysenter(vaddr_t ret_addr) {
+  Assert(cpu.sysenter_eip != 0, "sysenter before IA32_SYSENTER_EIP is set: eip = 0x%08x", cpu.eip);
+  push_frame(ret_addr);
+  cpu.eflags.IF = 0;
+
+  decoding.is_jmp = 1;
+  decoding.jmp_eip = cpu.sysenter_eip;
+
+  pmu.exception ++;
+}
+
+/* A page fault is raised in the middle of an instruction. Go back to
+ * exec_wrapper(), which rolls back the instruction and then calls
+ * raise_page_fault(), so that the instruction is restarted after the
+ * handler returns. */
+void page_fault(vaddr_t addr, bool is_write) {
+  Assert(decoding.fault_env != NULL, "page fault: vaddr = 0x%08x, eip = 0x%08x", addr, cpu.eip);
+  cpu.cr2 = addr;
+  decoding.fault_error_code = (is_write ? 0x2 : 0);
+  longjmp(*decoding.fault_env, 1);
+}
+
+void raise_page_fault(void) {
+  Assert(cpu.idtr.limit != 0, "page fault before IDT is set: vaddr = 0x%08x, eip = 0x%08x", cpu.cr2, cpu.eip);
+  do_intr(14, cpu.eip, true, decoding.fault_error_code);
 }
 
-void dev_raise_intr() {
+/* Devices raise interrupts on line `irq', and only vCPU 0 receives them.
+ * This is called from the signal handler of the timer and from the threads
+ * of all vCPUs accessing devices. */
+void dev_raise_intr(int irq) {
+  __atomic_fetch_or(&cpus[0]->INTR, 1u << irq, __ATOMIC_RELAXED);
 }
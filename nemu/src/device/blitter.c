@@ -0,0 +1,110 @@
+#include "nemu.h"
+#include "device/port-io.h"
+
+/* 2D blitter. Commands are queued by the guest in a ring in its memory,
+ * and the whole batch from HEAD to TAIL is executed when TAIL is written.
+ * Addresses in commands are physical, widths and heights are in pixels,
+ * and pitches are in bytes.
+ */
+
+#define BLT_PORT 0x80   // Note that this is not the standard
+#define BASE_OFFSET  0    /* (w) physical address of the ring */
+#define SIZE_OFFSET  4    /* (w) number of entries in the ring, a power of 2 */
+#define HEAD_OFFSET  8    /* (r) index of the next command to execute */
+#define TAIL_OFFSET  12   /* (w) doorbell, index after the last queued command */
+#define ERROR_OFFSET 16   /* (r) number of rejected commands */
+
+enum {
+  BLT_FILL = 1,   /* dst <- arg (an ARGB colour) */
+  BLT_COPY,       /* dst <- src, both 32-bit pixels */
+  BLT_PAL8,       /* dst <- palette[src], src is 8-bit, arg is the palette address */
+};
+
+typedef struct {
+  uint32_t op;
+  uint32_t dst, src;
+  uint32_t w, h;
+  uint32_t dst_pitch, src_pitch;
+  uint32_t arg;
+} BltCmd;
+
+static uint32_t *blt_port_base;
+
+/* Return where a rectangle of guest memory is on the host, or NULL if a
+ * row is longer than the pitch or the rectangle is not all in memory.
+ * The sizes are computed in 64 bits, since all of them come from the guest. */
+static void *rect_host_addr(paddr_t addr, uint32_t w, uint32_t h, uint32_t pitch, int bpp) {
+  uint64_t row = (uint64_t)w * bpp;
+  if (pitch < row) { return NULL; }
+  return paddr_host_range(addr, (uint64_t)pitch * (h - 1) + row);
+}
+
+static bool blt_exec(const BltCmd *c) {
+  if (c->w == 0 || c->h == 0) { return true; }
+
+  uint8_t *dst = rect_host_addr(c->dst, c->w, c->h, c->dst_pitch, 4);
+  if (dst == NULL) { return false; }
+
+  int i, j;
+  switch (c->op) {
+    case BLT_FILL:
+      for (i = 0; i < c->h; i ++, dst += c->dst_pitch) {
+        uint32_t *p = (void *)dst;
+        for (j = 0; j < c->w; j ++) { p[j] = c->arg; }
+      }
+      return true;
+
+    case BLT_COPY: {
+      uint8_t *src = rect_host_addr(c->src, c->w, c->h, c->src_pitch, 4);
+      if (src == NULL) { return false; }
+      for (i = 0; i < c->h; i ++, dst += c->dst_pitch, src += c->src_pitch) {
+        memmove(dst, src, c->w * 4);
+      }
+      return true;
+    }
+
+    case BLT_PAL8: {
+      uint8_t *src = rect_host_addr(c->src, c->w, c->h, c->src_pitch, 1);
+      uint32_t *pal = paddr_host_range(c->arg, 256 * sizeof(uint32_t));
+      if (src == NULL || pal == NULL) { return false; }
+      for (i = 0; i < c->h; i ++, dst += c->dst_pitch, src += c->src_pitch) {
+        uint32_t *p = (void *)dst;
+        for (j = 0; j < c->w; j ++) { p[j] = pal[src[j]]; }
+      }
+      return true;
+    }
+
+    default: return false;
+  }
+}
+
+void blt_io_handler(ioaddr_t addr, int len, bool is_write) {
+  if (!is_write || addr != BLT_PORT + TAIL_OFFSET) { return; }
+
+  // a bad ring is counted as an error like a bad command, nothing is executed
+  uint32_t base = blt_port_base[BASE_OFFSET / 4];
+  uint32_t size = blt_port_base[SIZE_OFFSET / 4];
+  if (size == 0 || (size & (size - 1)) != 0) {
+    blt_port_base[ERROR_OFFSET / 4] ++;
+    return;
+  }
+  uint32_t tail = blt_port_base[TAIL_OFFSET / 4] & (size - 1);
+  uint32_t *head = &blt_port_base[HEAD_OFFSET / 4];
+
+  BltCmd *ring = paddr_host_range(base, (uint64_t)size * sizeof(BltCmd));
+  if (ring == NULL) {
+    blt_port_base[ERROR_OFFSET / 4] ++;
+    return;
+  }
+  *head &= size - 1;
+
+  for (; *head != tail; *head = (*head + 1) & (size - 1)) {
+    if (!blt_exec(&ring[*head])) {
+      blt_port_base[ERROR_OFFSET / 4] ++;
+    }
+  }
+}
+
+void init_blitter() {
+  blt_port_base = add_pio_map(BLT_PORT, 20, blt_io_handler);
+}
@@ -18,8 +18,13 @@ void init_serial();
 void init_timer();
 void init_vga();
 void init_i8042();
+void init_mp();
+void init_pmu();
+void init_blitter();
+void init_disk();
 
 extern void timer_intr();
+extern void update_time_page();
 extern void send_key(uint8_t, bool);
 extern void update_screen();
 
@@ -38,6 +43,8 @@ static void timer_sig_handler(int signum) {
 }
 
 void device_update() {
+  update_time_page();
+
   if (!device_update_flag) {
     return;
   }
@@ -78,6 +85,10 @@ void init_device() {
   init_timer();
   init_vga();
   init_i8042();
+  init_mp();
+  init_pmu();
+  init_blitter();
+  init_disk();
 
   struct sigaction s;
   memset(&s, 0, sizeof(s));
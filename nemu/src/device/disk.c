@@ -0,0 +1,70 @@
+#include "nemu.h"
+#include "device/port-io.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+/* A block device backed by the host file given with `-d'. The guest sets
+ * the first sector, the number of sectors and the physical address of the
+ * buffer, then writes the command. The sectors are transferred between the
+ * file and the buffer before the write of the command returns, and an
+ * interrupt is raised on completion if it is enabled.
+ */
+
+#define DISK_PORT 0xa0   // Note that this is not the standard
+#define SECTOR_OFFSET 0   /* (w) the first sector */
+#define COUNT_OFFSET  4   /* (w) number of sectors */
+#define ADDR_OFFSET   8   /* (w) physical address of the buffer */
+#define CMD_OFFSET    12  /* (w) doorbell, DISK_READ or DISK_WRITE */
+#define STATUS_OFFSET 16  /* (r) DISK_OK or DISK_ERROR of the last command */
+#define SIZE_OFFSET   20  /* (r) number of sectors, 0 if there is no disk */
+#define CTRL_OFFSET   24  /* (w) DISK_IRQ_ENABLE */
+
+#define SECTOR_SIZE 512
+#define IRQ_DISK 14
+
+enum { DISK_READ = 1, DISK_WRITE };
+enum { DISK_OK = 0, DISK_ERROR };
+#define DISK_IRQ_ENABLE 0x1
+
+extern char *disk_img;
+static int disk_fd = -1;
+static uint32_t *disk_port_base;
+
+static bool disk_rw(bool is_write) {
+  uint32_t sector = disk_port_base[SECTOR_OFFSET / 4];
+  uint32_t count = disk_port_base[COUNT_OFFSET / 4];
+  uint32_t nr_sector = disk_port_base[SIZE_OFFSET / 4];
+  if (sector > nr_sector || count > nr_sector - sector) { return false; }
+
+  size_t len = (size_t)count * SECTOR_SIZE;
+  off_t offset = (off_t)sector * SECTOR_SIZE;
+  void *buf = paddr_host_range(disk_port_base[ADDR_OFFSET / 4], len);
+  if (buf == NULL) { return false; }
+
+  ssize_t ret = (is_write ? pwrite(disk_fd, buf, len, offset) : pread(disk_fd, buf, len, offset));
+  return ret == len;
+}
+
+void disk_io_handler(ioaddr_t addr, int len, bool is_write) {
+  if (!is_write || addr != DISK_PORT + CMD_OFFSET) { return; }
+
+  uint32_t cmd = disk_port_base[CMD_OFFSET / 4];
+  bool ok = (disk_fd >= 0 && (cmd == DISK_READ || cmd == DISK_WRITE) && disk_rw(cmd == DISK_WRITE));
+  disk_port_base[STATUS_OFFSET / 4] = (ok ? DISK_OK : DISK_ERROR);
+
+  if (disk_port_base[CTRL_OFFSET / 4] & DISK_IRQ_ENABLE) {
+    extern void dev_raise_intr(int irq);
+    dev_raise_intr(IRQ_DISK);
+  }
+}
+
+void init_disk() {
+  disk_port_base = add_pio_map(DISK_PORT, 28, disk_io_handler);
+  if (disk_img == NULL) { return; }
+
+  disk_fd = open(disk_img, O_RDWR);
+  Assert(disk_fd >= 0, "Can not open '%s'", disk_img);
+  off_t size = lseek(disk_fd, 0, SEEK_END);
+  disk_port_base[SIZE_OFFSET / 4] = size / SECTOR_SIZE;
+  Log("The disk image is %s, %d sectors", disk_img, (int)(size / SECTOR_SIZE));
+}
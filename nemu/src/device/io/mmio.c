@@ -1,7 +1,8 @@
 #include "common.h"
 #include "device/mmio.h"
+#include <pthread.h>
 
-#define MMIO_SPACE_MAX (512 * 1024)
+#define MMIO_SPACE_MAX (1024 * 1024)
 #define NR_MAP 8
 
 static uint8_t mmio_space_pool[MMIO_SPACE_MAX];
@@ -17,6 +18,9 @@ typedef struct {
 static MMIO_t maps[NR_MAP];
 static int nr_map = 0;
 
+/* serialize device accesses from different CPUs */
+static pthread_mutex_t mmio_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /* device interface */
 void* add_mmio_map(paddr_t addr, int len, mmio_callback_t callback) {
   assert(nr_map < NR_MAP);
@@ -43,12 +47,34 @@ int is_mmio(paddr_t addr) {
   return -1;
 }
 
+/* Return the map containing the whole range [addr, addr + len),
+ * -1 if the range does not touch any map, or -2 if it straddles a map. */
+int mmio_range(paddr_t addr, size_t len) {
+  paddr_t end = addr + len - 1;
+  int i;
+  for (i = 0; i < nr_map; i ++) {
+    if (addr >= maps[i].low && end <= maps[i].high) {
+      return i;
+    }
+    if (addr <= maps[i].high && end >= maps[i].low) {
+      return -2;
+    }
+  }
+  return -1;
+}
+
+void* mmio_host_addr(paddr_t addr, int map_NO) {
+  return maps[map_NO].mmio_space + (addr - maps[map_NO].low);
+}
+
 uint32_t mmio_read(paddr_t addr, int len, int map_NO) {
   assert(len >= 1 && len <= 4);
   MMIO_t *map = &maps[map_NO];
+  pthread_mutex_lock(&mmio_lock);
   uint32_t data = *(uint32_t *)(map->mmio_space + (addr - map->low)) 
     & (~0u >> ((4 - len) << 3));
   map->callback(addr, len, false);
+  pthread_mutex_unlock(&mmio_lock);
   return data;
 }
 
@@ -59,6 +85,7 @@ void mmio_write(paddr_t addr, int len, uint32_t data, int map_NO) {
   uint8_t *p = map->mmio_space + (addr - map->low);
   uint8_t *p_data = (uint8_t *)&data;
 
+  pthread_mutex_lock(&mmio_lock);
   switch (len) {
     case 4: p[3] = p_data[3];
     case 3: p[2] = p_data[2];
@@ -67,4 +94,5 @@ void mmio_write(paddr_t addr, int len, uint32_t data, int map_NO) {
   }
 
   maps[map_NO].callback(addr, len, true);
+  pthread_mutex_unlock(&mmio_lock);
 }
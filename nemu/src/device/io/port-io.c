@@ -1,8 +1,9 @@
 #include "common.h"
 #include "device/port-io.h"
+#include <pthread.h>
 
 #define PORT_IO_SPACE_MAX 65536
-#define NR_MAP 8
+#define NR_MAP 16
 
 /* "+ 3" is for hacking, see pio_read() below */
 static uint8_t pio_space[PORT_IO_SPACE_MAX + 3];
@@ -16,6 +17,10 @@ typedef struct {
 static PIO_t maps[NR_MAP];
 static int nr_map = 0;
 
+/* the data of a port is prepared by the callback and then picked up,
+ * so accesses from different CPUs must not interleave */
+static pthread_mutex_t pio_lock = PTHREAD_MUTEX_INITIALIZER;
+
 static void pio_callback(ioaddr_t addr, int len, bool is_write) {
   int i;
   for (i = 0; i < nr_map; i ++) {
@@ -42,15 +47,19 @@ void* add_pio_map(ioaddr_t addr, int len, pio_callback_t callback) {
 uint32_t pio_read(ioaddr_t addr, int len) {
   assert(len == 1 || len == 2 || len == 4);
   assert(addr + len - 1 < PORT_IO_SPACE_MAX);
+  pthread_mutex_lock(&pio_lock);
   pio_callback(addr, len, false);		// prepare data to read
   uint32_t data = *(uint32_t *)(pio_space + addr) & (~0u >> ((4 - len) << 3));
+  pthread_mutex_unlock(&pio_lock);
   return data;
 }
 
 void pio_write(ioaddr_t addr, int len, uint32_t data) {
   assert(len == 1 || len == 2 || len == 4);
   assert(addr + len - 1 < PORT_IO_SPACE_MAX);
+  pthread_mutex_lock(&pio_lock);
   memcpy(pio_space + addr, &data, len);
   pio_callback(addr, len, true);
+  pthread_mutex_unlock(&pio_lock);
 }
 
@@ -0,0 +1,28 @@
+#include "nemu.h"
+#include "device/port-io.h"
+
+/* Multi-processor control, used by the MPE of AM */
+
+#define MP_PORT 0x4c   // Note that this is not the standard
+#define CPUID_OFFSET 0   /* (r) number of the CPU performing the access */
+#define NRCPU_OFFSET 4   /* (r) number of CPUs */
+#define ENTRY_OFFSET 8   /* (w) where application processors start */
+#define BOOT_OFFSET  12  /* (w) start the next application processor with this esp */
+
+int boot_ap(vaddr_t, vaddr_t);
+
+static uint32_t *mp_port_base;
+
+void mp_io_handler(ioaddr_t addr, int len, bool is_write) {
+  if (!is_write) {
+    mp_port_base[CPUID_OFFSET / 4] = cpu_id;
+    mp_port_base[NRCPU_OFFSET / 4] = nr_cpu;
+  }
+  else if (addr == MP_PORT + BOOT_OFFSET) {
+    boot_ap(mp_port_base[ENTRY_OFFSET / 4], mp_port_base[BOOT_OFFSET / 4]);
+  }
+}
+
+void init_mp() {
+  mp_port_base = add_pio_map(MP_PORT, 16, mp_io_handler);
+}
@@ -0,0 +1,47 @@
+#include "nemu.h"
+#include "cpu/pmu.h"
+#include "device/port-io.h"
+#include <time.h>
+
+/* Performance counters, readable by the vCPU owning them */
+
+#define PMU_PORT 0x70   // Note that this is not the standard
+#define SEL_OFFSET 0    /* (w) latch the counter with this index */
+#define LO_OFFSET  4    /* (r) low 32 bits of the latched counter */
+#define HI_OFFSET  8    /* (r) high 32 bits of the latched counter */
+
+__thread PMU_state pmu;
+
+static struct timespec boot_time;
+
+/* The time stamp counter ticks at 1GHz since NEMU started. */
+uint64_t get_tsc(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)(now.tv_sec - boot_time.tv_sec) * 1000000000 + now.tv_nsec - boot_time.tv_nsec;
+}
+
+static uint32_t *pmu_port_base;
+
+void pmu_io_handler(ioaddr_t addr, int len, bool is_write) {
+  if (is_write && addr == PMU_PORT + SEL_OFFSET) {
+    uint64_t val;
+    switch (pmu_port_base[SEL_OFFSET / 4]) {
+      case PMU_INSTR:     val = pmu.instr; break;
+      case PMU_LOAD:      val = pmu.load; break;
+      case PMU_STORE:     val = pmu.store; break;
+      case PMU_MMIO:      val = pmu.mmio; break;
+      case PMU_BRANCH:    val = pmu.branch; break;
+      case PMU_EXCEPTION: val = pmu.exception; break;
+      case PMU_TSC:       val = get_tsc(); break;
+      default:            val = 0; break;
+    }
+    pmu_port_base[LO_OFFSET / 4] = (uint32_t)val;
+    pmu_port_base[HI_OFFSET / 4] = val >> 32;
+  }
+}
+
+void init_pmu() {
+  clock_gettime(CLOCK_MONOTONIC, &boot_time);
+  pmu_port_base = add_pio_map(PMU_PORT, 12, pmu_io_handler);
+}
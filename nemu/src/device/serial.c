@@ -1,4 +1,4 @@
-#include "common.h"
+#include "nemu.h"
 #include "device/port-io.h"
 
 /* http://en.wikibooks.org/wiki/Serial_Programming/8250_UART_Programming */
@@ -7,7 +7,14 @@
 #define CH_OFFSET 0
 #define LSR_OFFSET 5		/* line status register */
 
+/* Bulk output: the guest writes the physical address of a string, then its
+ * length, and the whole string is sent to the host at once. */
+#define SERIAL_DMA_PORT 0x98   // Note that this is not the standard
+#define ADDR_OFFSET 0   /* (w) physical address of the string */
+#define LEN_OFFSET  4   /* (w) doorbell, number of bytes to send */
+
 static uint8_t *serial_port_base;
+static uint32_t *serial_dma_base;
 
 void serial_io_handler(ioaddr_t addr, int len, bool is_write) {
   if (is_write) {
@@ -23,7 +30,23 @@ void serial_io_handler(ioaddr_t addr, int len, bool is_write) {
   }
 }
 
+void serial_dma_handler(ioaddr_t addr, int len, bool is_write) {
+  if (!is_write || addr != SERIAL_DMA_PORT + LEN_OFFSET) { return; }
+
+  uint32_t n = serial_dma_base[LEN_OFFSET / 4];
+  if (n == 0) { return; }
+  const char *s = paddr_host_range(serial_dma_base[ADDR_OFFSET / 4], n);
+  // a string out of memory is ignored, as the disk ignores a bad buffer
+  if (s == NULL) { return; }
+
+  fwrite(s, 1, n, stdout);
+  if (memchr(s, '\n', n) != NULL) {
+    fflush(stdout);
+  }
+}
+
 void init_serial() {
   serial_port_base = add_pio_map(SERIAL_PORT, 8, serial_io_handler);
+  serial_dma_base = add_pio_map(SERIAL_DMA_PORT, 8, serial_dma_handler);
   serial_port_base[LSR_OFFSET] = 0x20; /* the status is always free */
 }
@@ -1,13 +1,28 @@
 #include "device/port-io.h"
+#include "device/mmio.h"
 #include "monitor/monitor.h"
 #include <sys/time.h>
+#include <time.h>
 
 #define RTC_PORT 0x48   // Note that this is not the standard
+#define IRQ_TIMER 0
+
+/* The time page is refreshed by NEMU while the guest is running, so the
+ * guest can read the time with plain loads instead of accessing the RTC.
+ * The microsecond counter is 64-bit and is protected by a sequence number,
+ * which is odd while the page is being updated.
+ */
+#define TIME_PAGE 0xc0000   // Note that this is not the standard
+#define TIME_PAGE_SIZE 4096
+#define SEQ_OFFSET  0   /* sequence number */
+#define MSEC_OFFSET 4   /* milliseconds since NEMU started */
+#define USEC_OFFSET 8   /* microseconds since NEMU started, 64-bit */
+#define TIME_PAGE_UPDATE_INTERVAL 1024  /* in instructions */
 
 void timer_intr() {
   if (nemu_state == NEMU_RUNNING) {
-    extern void dev_raise_intr(void);
-    dev_raise_intr();
+    extern void dev_raise_intr(int irq);
+    dev_raise_intr(IRQ_TIMER);
   }
 }
 
@@ -23,6 +38,35 @@ void rtc_io_handler(ioaddr_t addr, int len, bool is_write) {
   }
 }
 
+static uint32_t *time_page_base;
+static struct timespec boot_time;
+
+void time_page_io_handler(paddr_t addr, int len, bool is_write) {
+}
+
+void update_time_page() {
+  static int cnt = 0;
+  if (++ cnt < TIME_PAGE_UPDATE_INTERVAL) {
+    return;
+  }
+  cnt = 0;
+
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  uint64_t us = (uint64_t)(now.tv_sec - boot_time.tv_sec) * 1000000 +
+    (now.tv_nsec - boot_time.tv_nsec) / 1000;
+
+  uint32_t *seq = &time_page_base[SEQ_OFFSET / 4];
+  __atomic_store_n(seq, *seq + 1, __ATOMIC_RELEASE);
+  time_page_base[MSEC_OFFSET / 4] = us / 1000;
+  time_page_base[USEC_OFFSET / 4] = (uint32_t)us;
+  time_page_base[USEC_OFFSET / 4 + 1] = us >> 32;
+  __atomic_store_n(seq, *seq + 1, __ATOMIC_RELEASE);
+}
+
 void init_timer() {
   rtc_port_base = add_pio_map(RTC_PORT, 4, rtc_io_handler);
+
+  clock_gettime(CLOCK_MONOTONIC, &boot_time);
+  time_page_base = add_mmio_map(TIME_PAGE, TIME_PAGE_SIZE, time_page_io_handler);
 }
@@ -1,5 +1,6 @@
 #include "nemu.h"
 #include "device/mmio.h"
+#include "cpu/pmu.h"
 
 #define PMEM_SIZE (128 * 1024 * 1024)
 
@@ -16,22 +17,165 @@ uint32_t paddr_read(paddr_t addr, int len) {
   int r = is_mmio(addr);
   if (r == -1)
     return pmem_rw(addr, uint32_t) & (~0u >> ((4 - len) << 3));
-  else
+  else {
+    pmu.mmio ++;
     return mmio_read(addr, len, r);
+  }
 }
 
 void paddr_write(paddr_t addr, int len, uint32_t data) {
   int r = is_mmio(addr);
   if (r == -1)
     memcpy(guest_to_host(addr), &data, len);
-  else
+  else {
+    pmu.mmio ++;
     mmio_write(addr, len, data, r);
+  }
+}
+
+/* Atomically store `data' and return the old value. Device registers are
+ * not shared memory, so they are simply read and then written. */
+uint32_t paddr_xchg(paddr_t addr, int len, uint32_t data) {
+  int r = is_mmio(addr);
+  if (r != -1) {
+    pmu.mmio += 2;
+    uint32_t old = mmio_read(addr, len, r);
+    mmio_write(addr, len, data, r);
+    return old;
+  }
+
+  switch (len) {
+    case 1: return __atomic_exchange_n(&pmem_rw(addr, uint8_t), data, __ATOMIC_SEQ_CST);
+    case 2: return __atomic_exchange_n(&pmem_rw(addr, uint16_t), data, __ATOMIC_SEQ_CST);
+    case 4: return __atomic_exchange_n(&pmem_rw(addr, uint32_t), data, __ATOMIC_SEQ_CST);
+    default: assert(0);
+  }
+}
+
+/* Atomically store `data' if the memory still holds `old'. */
+bool paddr_cmpxchg(paddr_t addr, int len, uint32_t old, uint32_t data) {
+  int r = is_mmio(addr);
+  if (r != -1) {
+    pmu.mmio ++;
+    mmio_write(addr, len, data, r);
+    return true;
+  }
+
+  switch (len) {
+    case 1: {
+      uint8_t expected = old;
+      return __atomic_compare_exchange_n(&pmem_rw(addr, uint8_t), &expected, data,
+          false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    }
+    case 2: {
+      uint16_t expected = old;
+      return __atomic_compare_exchange_n(&pmem_rw(addr, uint16_t), &expected, data,
+          false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    }
+    case 4: {
+      uint32_t expected = old;
+      return __atomic_compare_exchange_n(&pmem_rw(addr, uint32_t), &expected, data,
+          false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    }
+    default: assert(0);
+  }
+}
+
+/* Return the host address of the physical range [addr, addr + len),
+ * or NULL if it is not backed by a single region of either memory or
+ * device space. Device callbacks are not invoked for such accesses. */
+void* paddr_host_range(paddr_t addr, size_t len) {
+  if (len == 0 || (uint64_t)addr + len > 0x100000000ull) { return NULL; }
+
+  int r = mmio_range(addr, len);
+  if (r >= 0) { return mmio_host_addr(addr, r); }
+  if (r == -1 && addr + len <= PMEM_SIZE) { return guest_to_host(addr); }
+  return NULL;
+}
+
+void page_fault(vaddr_t addr, bool is_write) __attribute__((noreturn));
+
+/* Walk the two-level page table rooted at CR3. The accessed bit is set
+ * on both levels, and the dirty bit on the PTE for writes. A missing
+ * mapping raises #PF and does not return. */
+static paddr_t page_translate(vaddr_t addr, bool is_write) {
+  if (!cpu.cr0.paging) { return addr; }
+
+  paddr_t pde_addr = (cpu.cr3.page_directory_base << 12) + ((addr >> 22) << 2);
+  PDE pde;
+  pde.val = paddr_read(pde_addr, 4);
+  if (!pde.present) { page_fault(addr, is_write); }
+
+  paddr_t pte_addr = (pde.page_frame << 12) + (((addr >> 12) & 0x3ff) << 2);
+  PTE pte;
+  pte.val = paddr_read(pte_addr, 4);
+  if (!pte.present) { page_fault(addr, is_write); }
+
+  if (!pde.accessed) {
+    pde.accessed = 1;
+    paddr_write(pde_addr, 4, pde.val);
+  }
+  if (!pte.accessed || (is_write && !pte.dirty)) {
+    pte.accessed = 1;
+    pte.dirty |= is_write;
+    paddr_write(pte_addr, 4, pte.val);
+  }
+
+  return (pte.page_frame << 12) | (addr & PAGE_MASK);
+}
+
+static inline bool cross_page(vaddr_t addr, int len) {
+  return ((addr & PAGE_MASK) + len) > PAGE_SIZE;
+}
+
+/* Translate the two pages of an access spanning a page boundary, which
+ * may not be physically adjacent. Both are translated before any byte
+ * is accessed, so that a fault in the second page leaves memory intact. */
+static void translate_cross_page(vaddr_t addr, int len, bool is_write, paddr_t *paddr) {
+  paddr_t lo = page_translate(addr, is_write);
+  paddr_t hi = page_translate(addr + len - 1, is_write) & ~PAGE_MASK;
+  int i;
+  for (i = 0; i < len; i ++) {
+    vaddr_t va = addr + i;
+    paddr[i] = ((va & ~PAGE_MASK) == (addr & ~PAGE_MASK) ? lo + i : hi | (va & PAGE_MASK));
+  }
 }
 
 uint32_t vaddr_read(vaddr_t addr, int len) {
-  return paddr_read(addr, len);
+  if (cross_page(addr, len)) {
+    paddr_t paddr[4];
+    translate_cross_page(addr, len, false, paddr);
+    uint32_t data = 0;
+    int i;
+    for (i = 0; i < len; i ++) {
+      data |= paddr_read(paddr[i], 1) << (i << 3);
+    }
+    return data;
+  }
+  return paddr_read(page_translate(addr, false), len);
 }
 
 void vaddr_write(vaddr_t addr, int len, uint32_t data) {
-  paddr_write(addr, len, data);
-}
\ No newline at end of file
+  if (cross_page(addr, len)) {
+    paddr_t paddr[4];
+    translate_cross_page(addr, len, true, paddr);
+    int i;
+    for (i = 0; i < len; i ++) {
+      paddr_write(paddr[i], 1, data >> (i << 3));
+    }
+    return;
+  }
+  paddr_write(page_translate(addr, true), len, data);
+}
+
+/* Atomic accesses are naturally aligned in practice, so they never span
+ * two pages. */
+uint32_t vaddr_xchg(vaddr_t addr, int len, uint32_t data) {
+  assert(!cross_page(addr, len));
+  return paddr_xchg(page_translate(addr, true), len, data);
+}
+
+bool vaddr_cmpxchg(vaddr_t addr, int len, uint32_t old, uint32_t data) {
+  assert(!cross_page(addr, len));
+  return paddr_cmpxchg(page_translate(addr, true), len, old, data);
+}
@@ -1,6 +1,7 @@
 #include "nemu.h"
 #include "monitor/monitor.h"
 #include "monitor/watchpoint.h"
+#include <pthread.h>
 /* The assembly code of instructions executed is only output to the screen
  * when the number of instructions executed is less than this value.
  * This is useful when you use the `si' command.
@@ -12,6 +13,78 @@ int nemu_state = NEMU_STOP;
 
 void exec_wrapper(bool);
 
+/* Application processors (vCPU 1 ~ nr_cpu - 1) run free on their own host
+ * threads while vCPU 0 is running, and park while the monitor has control.
+ */
+static pthread_mutex_t ap_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ap_cond = PTHREAD_COND_INITIALIZER;
+static int nr_booted_cpu = 1;
+
+static struct {
+  vaddr_t eip, esp;
+} ap_boot_info[NR_CPU_MAX];
+
+static void* ap_main(void *arg) {
+  cpu_id = (intptr_t)arg;
+  cpus[cpu_id] = &cpu;
+
+  cpu.eip = ap_boot_info[cpu_id].eip;
+  cpu.esp = ap_boot_info[cpu_id].esp;
+  cpu.cs = 8;
+  unsigned int origin = 2;
+  memcpy(&cpu.eflags, &origin, sizeof(cpu.eflags));
+  cpu.cr0.val = 0x60000011;
+
+  while (1) {
+    if (nemu_state != NEMU_RUNNING) {
+      pthread_mutex_lock(&ap_lock);
+      while (nemu_state == NEMU_STOP) {
+        pthread_cond_wait(&ap_cond, &ap_lock);
+      }
+      pthread_mutex_unlock(&ap_lock);
+      if (nemu_state == NEMU_END) { break; }
+    }
+
+    exec_wrapper(false);
+  }
+
+  return NULL;
+}
+
+/* Start the next application processor at `eip' with stack pointer `esp'.
+ * Return its CPU number, or -1 if all CPUs have been started.
+ */
+int boot_ap(vaddr_t eip, vaddr_t esp) {
+  pthread_mutex_lock(&ap_lock);
+  if (nr_booted_cpu >= nr_cpu) {
+    pthread_mutex_unlock(&ap_lock);
+    return -1;
+  }
+  int id = nr_booted_cpu ++;
+  pthread_mutex_unlock(&ap_lock);
+
+#ifdef DIFF_TEST
+  panic("differential testing does not support multiple CPUs");
+#endif
+
+  ap_boot_info[id].eip = eip;
+  ap_boot_info[id].esp = esp;
+
+  pthread_t tid;
+  int ret = pthread_create(&tid, NULL, ap_main, (void *)(intptr_t)id);
+  Assert(ret == 0, "Can not create the thread for CPU %d", id);
+  pthread_detach(tid);
+
+  Log("CPU %d is up at eip = 0x%08x, esp = 0x%08x", id, eip, esp);
+  return id;
+}
+
+static inline void wakeup_ap() {
+  pthread_mutex_lock(&ap_lock);
+  pthread_cond_broadcast(&ap_cond);
+  pthread_mutex_unlock(&ap_lock);
+}
+
 /* Simulate how the CPU works. */
 void cpu_exec(uint64_t n) {
   if (nemu_state == NEMU_END) {
@@ -19,6 +92,7 @@ void cpu_exec(uint64_t n) {
     return;
   }
   nemu_state = NEMU_RUNNING;
+  wakeup_ap();
 
   bool print_flag = n < MAX_INSTR_TO_PRINT;
 
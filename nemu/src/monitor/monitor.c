@@ -1,5 +1,6 @@
 #include "nemu.h"
 #include <unistd.h>
+#include <stdlib.h>
 
 #define ENTRY_START 0x100000
 
@@ -16,6 +17,7 @@ FILE *log_fp = NULL;
 static char *log_file = NULL;
 static char *img_file = NULL;
 static int is_batch_mode = false;
+char *disk_img = NULL;
 
 static inline void init_log() {
 #ifdef DEBUG
@@ -81,10 +83,12 @@ static inline void load_img() {
 
 static inline void restart() {
   /* Set the initial instruction pointer. */
+  cpus[0] = &cpu;
   cpu.eip = ENTRY_START;
   cpu.cs = 8;
   unsigned int origin=2;
   memcpy(&cpu.eflags, &origin, sizeof(cpu.eflags));
+  cpu.cr0.val = 0x60000011;
 
 #ifdef DIFF_TEST
   init_qemu_reg();
@@ -93,16 +97,21 @@ static inline void restart() {
 
 static inline void parse_args(int argc, char *argv[]) {
   int o;
-  while ( (o = getopt(argc, argv, "-bl:")) != -1) {
+  while ( (o = getopt(argc, argv, "-bl:c:d:")) != -1) {
     switch (o) {
       case 'b': is_batch_mode = true; break;
+      case 'c':
+                nr_cpu = atoi(optarg);
+                Assert(nr_cpu >= 1 && nr_cpu <= NR_CPU_MAX, "The number of CPUs should be 1 ~ %d", NR_CPU_MAX);
+                break;
       case 'l': log_file = optarg; break;
+      case 'd': disk_img = optarg; break;
       case 1:
                 if (img_file != NULL) Log("too much argument '%s', ignored", optarg);
                 else img_file = optarg;
                 break;
       default:
-                panic("Usage: %s [-b] [-l log_file] [img_file]", argv[0]);
+                panic("Usage: %s [-b] [-c nr_cpu] [-l log_file] [-d disk_img] [img_file]", argv[0]);
     }
   }
 }
@@ -60,6 +60,23 @@ typedef struct _Screen {
   int width, height;
 } _Screen;
 
+enum { _BLIT_FILL = 1, _BLIT_COPY, _BLIT_PAL8 };
+
+typedef struct _Blit {
+  int op;
+  int x, y, w, h;           // destination rectangle on the screen
+  const void *src;          // _BLIT_COPY: 32-bit pixels, _BLIT_PAL8: 8-bit indices
+  int pitch;                // pixels per row of src
+  uint32_t color;           // _BLIT_FILL
+  const uint32_t *palette;  // _BLIT_PAL8, 256 entries
+} _Blit;
+
+// Counts of guest events. Unlike the time and _rdtsc(), which follow the
+// host clock, they do not depend on the host running the program.
+typedef struct _PerfCnt {
+  uint64_t instr, load, store, mmio, branch, exception;
+} _PerfCnt;
+
 typedef struct _Protect {
   _Area area; 
   void *ptr;
@@ -74,6 +91,7 @@ extern "C" {
 // =======================================================================
 
 void _putc(char ch);
+void _puts(const char *s, size_t n);
 void _halt(int code);
 extern _Area _heap;
 
@@ -86,6 +104,14 @@ unsigned long _uptime();
 int _read_key();
 void _draw_rect(const uint32_t *pixels, int x, int y, int w, int h);
 void _draw_sync();
+void _blit(const _Blit *ops, int n);
+uint32_t *_framebuffer();
+#define _DISK_SECTOR_SIZE 512
+uint32_t _disk_size();
+int _disk_read(void *buf, uint32_t sector, int n);
+int _disk_write(const void *buf, uint32_t sector, int n);
+void _perf_read(_PerfCnt *cnt);
+uint64_t _rdtsc();
 extern _Screen _screen;
 
 // =======================================================================
@@ -105,7 +131,7 @@ void _pte_init(void*(*palloc)(), void (*pfree)(void*));
 void _protect(_Protect *p);
 void _release(_Protect *p);
 void _map(_Protect *p, void *va, void *pa);
-void _unmap(_Protect *p, void *va);
+void *_unmap(_Protect *p, void *va);
 void _switch(_Protect *p);
 _RegSet *_umake(_Protect *p, _Area ustack, _Area kstack, void *entry, char *const argv[], char *const envp[]);
 
@@ -54,6 +54,33 @@ void _draw_rect(const uint32_t *pixels, int x, int y, int w, int h) {
   }
 }
 
+void _blit(const _Blit *ops, int n) {
+  for (int i = 0; i < n; i ++) {
+    const _Blit *b = &ops[i];
+    int x = b->x, y = b->y, w = b->w, h = b->h, sx = 0, sy = 0;
+    if (x < 0) { sx = -x; w += x; x = 0; }
+    if (y < 0) { sy = -y; h += y; y = 0; }
+    w = min(w, _screen.width - x);
+    h = min(h, _screen.height - y);
+
+    for (int j = 0; j < h; j ++) {
+      uint32_t *dst = &fb[(y + j) * W + x];
+      int off = (sy + j) * b->pitch + sx;
+      for (int k = 0; k < w; k ++) {
+        switch (b->op) {
+          case _BLIT_FILL: dst[k] = b->color; break;
+          case _BLIT_COPY: dst[k] = ((const uint32_t *)b->src)[off + k]; break;
+          case _BLIT_PAL8: dst[k] = b->palette[((const uint8_t *)b->src)[off + k]]; break;
+        }
+      }
+    }
+  }
+}
+
+uint32_t *_framebuffer() {
+  return fb;
+}
+
 void _draw_sync() {
   SDL_UpdateTexture(texture, NULL, fb, W * sizeof(Uint32));
   SDL_RenderClear(renderer);
@@ -1,6 +1,8 @@
 #include <am.h>
 #include <sys/time.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <stdlib.h>
 
 static struct timeval boot_time;
 
@@ -12,11 +14,41 @@ unsigned long _uptime() {
   return seconds * 1000 + (useconds + 500) / 1000;
 }
 
+// there are no guest-visible counters in native
+void _perf_read(_PerfCnt *cnt) {
+  cnt->instr = cnt->load = cnt->store = 0;
+  cnt->mmio = cnt->branch = cnt->exception = 0;
+}
+
+uint64_t _rdtsc() {
+  return __builtin_ia32_rdtsc();
+}
+
+// the disk is the host file given by the environment variable AM_DISK
+static int disk_fd = -1;
+
+uint32_t _disk_size() {
+  return (disk_fd < 0 ? 0 : lseek(disk_fd, 0, SEEK_END) / _DISK_SECTOR_SIZE);
+}
+
+int _disk_read(void *buf, uint32_t sector, int n) {
+  size_t len = (size_t)n * _DISK_SECTOR_SIZE;
+  return (disk_fd >= 0 && pread(disk_fd, buf, len, (off_t)sector * _DISK_SECTOR_SIZE) == len ? 0 : -1);
+}
+
+int _disk_write(const void *buf, uint32_t sector, int n) {
+  size_t len = (size_t)n * _DISK_SECTOR_SIZE;
+  return (disk_fd >= 0 && pwrite(disk_fd, buf, len, (off_t)sector * _DISK_SECTOR_SIZE) == len ? 0 : -1);
+}
+
 void gui_init();
 
 void _ioe_init() {
   gui_init();
   gettimeofday(&boot_time, NULL);
+  if (getenv("AM_DISK") != NULL) {
+    disk_fd = open(getenv("AM_DISK"), O_RDWR);
+  }
 }
 
 
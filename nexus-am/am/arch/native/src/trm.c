@@ -13,6 +13,10 @@ void _putc(char ch) {
   putchar(ch);
 }
 
+void _puts(const char *s, size_t n) {
+  fwrite(s, 1, n, stdout);
+}
+
 void _halt(int code) {
   printf("Exit (%d)\n", code);
   _exit(code);
@@ -20,6 +20,7 @@ struct _RegSet {
 #define SYSCALL_ARG2(r) r -> ebx
 #define SYSCALL_ARG3(r) r -> ecx
 #define SYSCALL_ARG4(r) r -> edx
+#define SYSCALL_ARG5(r) r -> esi
 
 #ifdef __cplusplus
 extern "C" {
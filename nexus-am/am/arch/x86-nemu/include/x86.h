@@ -110,6 +110,32 @@ static inline void set_cr3(void *pdir) {
   asm volatile("movl %0, %%cr3" : : "r"(pdir));
 }
 
+static inline uint32_t get_efl(void) {
+  volatile uint32_t efl;
+  asm volatile("pushf; pop %0": "=r"(efl));
+  return efl;
+}
+
+static inline void cli(void) {
+  asm volatile("cli");
+}
+
+static inline void sti(void) {
+  asm volatile("sti");
+}
+
+#define MSR_SYSENTER_EIP 0x176
+
+static inline void wrmsr(uint32_t msr, uint64_t val) {
+  asm volatile("wrmsr" : : "c"(msr), "a"((uint32_t)val), "d"((uint32_t)(val >> 32)));
+}
+
+static inline uint32_t get_cr2(void) {
+  volatile uint32_t val;
+  asm volatile("movl %%cr2, %0" : "=r"(val));
+  return val;
+}
+
 static inline uint8_t inb(int port) {
   char data;
   asm volatile("inb %1, %0" : "=a"(data) : "d"((uint16_t)port));
@@ -130,6 +156,38 @@ static inline void outl(int port, uint32_t data) {
   asm volatile("outl %%eax, %%dx" : : "a"(data), "d"((uint16_t)port));
 }
 
+// NEMU hypercalls: bulk memory operations done by the emulator itself.
+// They return 0 on success, and non-zero if NEMU rejects an address
+// range, in which case the caller should fall back to a plain loop.
+// Note that this is not the standard.
+
+#define NEMU_HC_MEMCPY 1
+#define NEMU_HC_MEMSET 2
+#define NEMU_HC_RECT   3
+
+static inline int nemu_memcpy(void *dst, const void *src, size_t n) {
+  int ret;
+  asm volatile(".byte 0xd7" : "=a"(ret)
+      : "a"(NEMU_HC_MEMCPY), "D"(dst), "S"(src), "c"(n) : "memory");
+  return ret;
+}
+
+static inline int nemu_memset(void *dst, int c, size_t n) {
+  int ret;
+  asm volatile(".byte 0xd7" : "=a"(ret)
+      : "a"(NEMU_HC_MEMSET), "D"(dst), "d"(c), "c"(n) : "memory");
+  return ret;
+}
+
+// copy h rows of w bytes, the pitches are in bytes
+static inline int nemu_rect(void *dst, const void *src, size_t w, size_t h,
+    size_t dst_pitch, size_t src_pitch) {
+  volatile uint32_t args[6] = { (uint32_t)dst, (uint32_t)src, w, h, dst_pitch, src_pitch };
+  int ret;
+  asm volatile(".byte 0xd7" : "=a"(ret) : "a"(NEMU_HC_RECT), "b"(args) : "memory");
+  return ret;
+}
+
 #endif
 
 #endif
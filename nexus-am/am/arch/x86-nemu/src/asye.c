@@ -5,6 +5,10 @@ static _RegSet* (*H)(_Event, _RegSet*) = NULL;
 
 void vecsys();
 void vecnull();
+void vecpf();
+void vectrap();
+void vectime();
+void vecsysenter();
 
 _RegSet* irq_handle(_RegSet *tf) {
   _RegSet *next = tf;
@@ -12,6 +16,9 @@ _RegSet* irq_handle(_RegSet *tf) {
     _Event ev;
     switch (tf->irq) {
       case 0x80: ev.event = _EVENT_SYSCALL; break;
+      case 0x81: ev.event = _EVENT_TRAP; break;
+      case 32: ev.event = _EVENT_IRQ_TIME; break;
+      case 14: ev.event = _EVENT_PAGE_FAULT; ev.cause = get_cr2(); break;
       default: ev.event = _EVENT_ERROR; break;
     }
 
@@ -24,6 +31,16 @@ _RegSet* irq_handle(_RegSet *tf) {
   return next;
 }
 
+// System calls made with sysenter come here without looking up the IDT
+// and the irq id.
+_RegSet* sysenter_handle(_RegSet *tf) {
+  _RegSet *next = NULL;
+  if (H) {
+    next = H((_Event) { .event = _EVENT_SYSCALL }, tf);
+  }
+  return (next == NULL ? tf : next);
+}
+
 static GateDesc idt[NR_IRQ];
 
 void _asye_init(_RegSet*(*h)(_Event, _RegSet*)) {
@@ -32,8 +49,17 @@ void _asye_init(_RegSet*(*h)(_Event, _RegSet*)) {
     idt[i] = GATE(STS_TG32, KSEL(SEG_KCODE), vecnull, DPL_KERN);
   }
 
+  // -------------------- page fault ---------------------------
+  // the error code is pushed by the CPU
+  idt[14] = GATE(STS_TG32, KSEL(SEG_KCODE), vecpf, DPL_KERN);
+
   // -------------------- system call --------------------------
   idt[0x80] = GATE(STS_TG32, KSEL(SEG_KCODE), vecsys, DPL_USER);
+  idt[0x81] = GATE(STS_TG32, KSEL(SEG_KCODE), vectrap, DPL_KERN);
+  wrmsr(MSR_SYSENTER_EIP, (uint32_t)vecsysenter);
+
+  // -------------------- timer interrupt ----------------------
+  idt[32] = GATE(STS_IG32, KSEL(SEG_KCODE), vectime, DPL_KERN);
 
   set_idt(idt, sizeof(idt));
 
@@ -41,13 +67,35 @@ void _asye_init(_RegSet*(*h)(_Event, _RegSet*)) {
   H = h;
 }
 
+// The context is built at the top of `stack', below a frame in which
+// `entry' is called with `arg' and a NULL return address. Interrupts are
+// enabled in the context.
 _RegSet *_make(_Area stack, void *entry, void *arg) {
-  return NULL;
+  uintptr_t *sp = stack.end;
+  *(-- sp) = (uintptr_t)arg;
+  *(-- sp) = 0;
+
+  _RegSet *r = (_RegSet*)sp - 1;
+  for (int i = 0; i < sizeof(_RegSet) / sizeof(uintptr_t); i ++) {
+    ((uintptr_t*)r)[i] = 0;
+  }
+  r->eip = (uintptr_t)entry;
+  r->cs = KSEL(SEG_KCODE);
+  r->eflags = FL_IF | 0x2;
+  return r;
 }
 
 void _trap() {
+  asm volatile("int $0x81");
 }
 
 int _istatus(int enable) {
-  return 0;
+  uint32_t eflags = get_efl();
+  if (enable) {
+    sti();
+  }
+  else {
+    cli();
+  }
+  return (eflags & FL_IF) != 0;
 }
@@ -2,14 +2,64 @@
 #include <x86.h>
 
 #define RTC_PORT 0x48   // Note that this is not standard
+#define PMU_PORT 0x70   // Note that this is not standard
+#define TIME_PAGE 0xc0000  // Note that this is not standard
+#define BLT_PORT 0x80      // Note that this is not standard
+#define BLT_RING_SIZE 64
+#define DISK_PORT 0xa0     // Note that this is not standard
 static unsigned long boot_time;
 
+// kept up to date by NEMU, so reading the time does not trap into the RTC
+typedef struct {
+  uint32_t seq;
+  uint32_t msec;
+  uint32_t usec_lo, usec_hi;
+} TimePage;
+
+static volatile TimePage* const time_page = (TimePage *)TIME_PAGE;
+
+// a command of the blitter, which executes the ring on a write to its tail
+typedef struct {
+  uint32_t op;
+  uint32_t dst, src;
+  uint32_t w, h;
+  uint32_t dst_pitch, src_pitch;
+  uint32_t arg;
+} BltCmd;
+
+static BltCmd blt_ring[BLT_RING_SIZE];
+static uint32_t blt_tail;
+
 void _ioe_init() {
-  boot_time = inl(RTC_PORT);
+  boot_time = time_page->msec;
+  outl(BLT_PORT, (uint32_t)blt_ring);
+  outl(BLT_PORT + 4, BLT_RING_SIZE);
 }
 
 unsigned long _uptime() {
-  return inl(RTC_PORT)-boot_time;
+  return time_page->msec - boot_time;
+}
+
+static uint64_t pmu_read(int sel) {
+  outl(PMU_PORT, sel);
+  uint32_t lo = inl(PMU_PORT + 4);
+  uint32_t hi = inl(PMU_PORT + 8);
+  return ((uint64_t)hi << 32) | lo;
+}
+
+void _perf_read(_PerfCnt *cnt) {
+  cnt->instr = pmu_read(0);
+  cnt->load = pmu_read(1);
+  cnt->store = pmu_read(2);
+  cnt->mmio = pmu_read(3);
+  cnt->branch = pmu_read(4);
+  cnt->exception = pmu_read(5);
+}
+
+uint64_t _rdtsc() {
+  uint32_t lo, hi;
+  asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+  return ((uint64_t)hi << 32) | lo;
 }
 
 uint32_t* const fb = (uint32_t *)0x40000;
@@ -21,15 +71,104 @@ _Screen _screen = {
 
 extern void* memcpy(void *, const void *, int);
 
+// The hypercalls and the blitter take physical addresses. With paging,
+// the pixels may be in user pages, so they are copied by the CPU instead.
+static inline int paging() {
+  return (get_cr0() & CR0_PG) != 0;
+}
+
 void _draw_rect(const uint32_t *pixels, int x, int y, int w, int h) {
   int temp = (w > _screen.width-x) ? _screen.width-x : w;
   int cp_bytes = sizeof(uint32_t)*temp;
+  int rows = (h > _screen.height-y) ? _screen.height-y : h;
+  if (cp_bytes <= 0 || rows <= 0) return;
+  if (!paging() && nemu_rect(&fb[y*_screen.width + x], pixels, cp_bytes, rows,
+        sizeof(uint32_t)*_screen.width, sizeof(uint32_t)*w) == 0) {
+    return;
+  }
+
   for (int j = 0; j < h && y + j < _screen.height; j++) {
     memcpy(&fb[(y + j)*_screen.width +x],pixels, cp_bytes);
     pixels += w;
   }
 }
 
+static void blit_cpu(const _Blit *b, int x, int y, int w, int h, int sx, int sy) {
+  for (int j = 0; j < h; j ++) {
+    uint32_t *dst = &fb[(y + j) * _screen.width + x];
+    switch (b->op) {
+      case _BLIT_FILL:
+        for (int i = 0; i < w; i ++) dst[i] = b->color;
+        break;
+      case _BLIT_COPY:
+        memcpy(dst, (const uint32_t *)b->src + (sy + j) * b->pitch + sx, w * sizeof(uint32_t));
+        break;
+      case _BLIT_PAL8: {
+        const uint8_t *src = (const uint8_t *)b->src + (sy + j) * b->pitch + sx;
+        for (int i = 0; i < w; i ++) dst[i] = b->palette[src[i]];
+        break;
+      }
+    }
+  }
+}
+
+// The blitter executes all queued commands synchronously when the tail
+// is written, so the ring is always empty between calls.
+void _blit(const _Blit *ops, int n) {
+  int nr_queued = 0;
+  int use_cpu = paging();
+  for (int i = 0; i < n; i ++) {
+    const _Blit *b = &ops[i];
+    int x = b->x, y = b->y, w = b->w, h = b->h, sx = 0, sy = 0;
+    if (x < 0) { sx = -x; w += x; x = 0; }
+    if (y < 0) { sy = -y; h += y; y = 0; }
+    if (w > _screen.width - x) w = _screen.width - x;
+    if (h > _screen.height - y) h = _screen.height - y;
+    if (w <= 0 || h <= 0) continue;
+    if (use_cpu) {
+      blit_cpu(b, x, y, w, h, sx, sy);
+      continue;
+    }
+
+    BltCmd *c = &blt_ring[blt_tail];
+    c->op = b->op;
+    c->dst = (uint32_t)&fb[y * _screen.width + x];
+    c->w = w;
+    c->h = h;
+    c->dst_pitch = _screen.width * sizeof(uint32_t);
+    switch (b->op) {
+      case _BLIT_FILL:
+        c->arg = b->color;
+        break;
+      case _BLIT_COPY:
+        c->src = (uint32_t)((const uint32_t *)b->src + sy * b->pitch + sx);
+        c->src_pitch = b->pitch * sizeof(uint32_t);
+        break;
+      case _BLIT_PAL8:
+        c->src = (uint32_t)((const uint8_t *)b->src + sy * b->pitch + sx);
+        c->src_pitch = b->pitch;
+        c->arg = (uint32_t)b->palette;
+        break;
+      default: continue;
+    }
+
+    blt_tail = (blt_tail + 1) % BLT_RING_SIZE;
+    if (++ nr_queued == BLT_RING_SIZE - 1) {
+      outl(BLT_PORT + 12, blt_tail);
+      nr_queued = 0;
+    }
+  }
+
+  if (nr_queued > 0) {
+    outl(BLT_PORT + 12, blt_tail);
+  }
+}
+
+// the VGA memory is shown by NEMU periodically
+uint32_t *_framebuffer() {
+  return fb;
+}
+
 void _draw_sync() {
 }
 
@@ -38,4 +177,43 @@ int _read_key() {
     return inl(0x60);
   else
     return _KEY_NONE;
-}
\ No newline at end of file
+}
+
+// The disk transfers sectors by DMA, which takes physical addresses. With
+// paging, the buffer may be in user pages, so it goes through a sector in
+// the kernel, which is identity mapped.
+static uint8_t disk_buf[_DISK_SECTOR_SIZE];
+
+static int disk_cmd(int cmd, void *buf, uint32_t sector, int n) {
+  outl(DISK_PORT, sector);
+  outl(DISK_PORT + 4, n);
+  outl(DISK_PORT + 8, (uint32_t)buf);
+  outl(DISK_PORT + 12, cmd);
+  return (inl(DISK_PORT + 16) == 0 ? 0 : -1);
+}
+
+uint32_t _disk_size() {
+  return inl(DISK_PORT + 20);
+}
+
+int _disk_read(void *buf, uint32_t sector, int n) {
+  if (!paging()) {
+    return disk_cmd(1, buf, sector, n);
+  }
+  for (int i = 0; i < n; i ++) {
+    if (disk_cmd(1, disk_buf, sector + i, 1) != 0) return -1;
+    memcpy((uint8_t *)buf + i * _DISK_SECTOR_SIZE, disk_buf, _DISK_SECTOR_SIZE);
+  }
+  return 0;
+}
+
+int _disk_write(const void *buf, uint32_t sector, int n) {
+  if (!paging()) {
+    return disk_cmd(2, (void *)buf, sector, n);
+  }
+  for (int i = 0; i < n; i ++) {
+    memcpy(disk_buf, (const uint8_t *)buf + i * _DISK_SECTOR_SIZE, _DISK_SECTOR_SIZE);
+    if (disk_cmd(2, disk_buf, sector + i, 1) != 0) return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,53 @@
+#include <am.h>
+#include <x86.h>
+
+#define MP_PORT 0x4c   // Note that this is not standard
+#define MP_CPUID (MP_PORT + 0)
+#define MP_NRCPU (MP_PORT + 4)
+#define MP_ENTRY (MP_PORT + 8)
+#define MP_BOOT  (MP_PORT + 12)
+
+#define AP_STACK_SIZE (4 * PGSIZE)
+
+int _NR_CPU = 1;
+
+static void (*mp_entry)();
+static uint8_t ap_stack[MAX_CPU - 1][AP_STACK_SIZE] __attribute((aligned(PGSIZE)));
+
+static void ap_entry() {
+  mp_entry();
+
+  // an application processor has nothing to return to
+  while (1);
+}
+
+void _mpe_init(void (*entry)()) {
+  mp_entry = entry;
+
+  _NR_CPU = inl(MP_NRCPU);
+  if (_NR_CPU > MAX_CPU) {
+    _NR_CPU = MAX_CPU;
+  }
+
+  outl(MP_ENTRY, (uint32_t)ap_entry);
+  for (int i = 1; i < _NR_CPU; i ++) {
+    outl(MP_BOOT, (uint32_t)&ap_stack[i - 1][AP_STACK_SIZE]);
+  }
+
+  entry();
+  _halt(0);
+}
+
+int _cpu() {
+  return inl(MP_CPUID);
+}
+
+intptr_t _atomic_xchg(volatile intptr_t *addr, intptr_t newval) {
+  intptr_t result;
+  asm volatile("xchgl %0, %1" : "+m"(*addr), "=a"(result) : "1"(newval) : "cc", "memory");
+  return result;
+}
+
+void _barrier() {
+  asm volatile("lock; addl $0, (%%esp)" : : : "cc", "memory");
+}
@@ -58,7 +58,17 @@ void _protect(_Protect *p) {
   p->area.end = (void*)0xc0000000;
 }
 
+// free the page tables of the user space and the page directory,
+// the pages mapped are owned by the caller
 void _release(_Protect *p) {
+  PDE *updir = p->ptr;
+  for (int i = 0; i < NR_PDE; i ++) {
+    if ((updir[i] & PTE_P) && updir[i] != kpdirs[i]) {
+      pfree_f((void*)PTE_ADDR(updir[i]));
+    }
+  }
+  pfree_f(updir);
+  p->ptr = NULL;
 }
 
 void _switch(_Protect *p) {
@@ -66,11 +76,46 @@ void _switch(_Protect *p) {
 }
 
 void _map(_Protect *p, void *va, void *pa) {
+  PDE *pde = (PDE*)p->ptr + PDX(va);
+  if (!(*pde & PTE_P)) {
+    PTE *ptab = (PTE*)(palloc_f());
+    for (int i = 0; i < NR_PTE; i ++) {
+      ptab[i] = 0;
+    }
+    *pde = (uintptr_t)ptab | PTE_P;
+  }
+
+  PTE *pte = (PTE*)PTE_ADDR(*pde) + PTX(va);
+  *pte = PTE_ADDR(pa) | PTE_P;
 }
 
-void _unmap(_Protect *p, void *va) {
+void *_unmap(_Protect *p, void *va) {
+  PDE pde = ((PDE*)p->ptr)[PDX(va)];
+  if (!(pde & PTE_P)) {
+    return NULL;
+  }
+
+  PTE *pte = (PTE*)PTE_ADDR(pde) + PTX(va);
+  void *pa = ((*pte & PTE_P) ? (void*)PTE_ADDR(*pte) : NULL);
+  *pte = 0;
+  return pa;
 }
 
+// There are no privilege levels in NEMU, so the program runs on `ustack'
+// with its context right below the frame for _start(argc, argv, envp).
 _RegSet *_umake(_Protect *p, _Area ustack, _Area kstack, void *entry, char *const argv[], char *const envp[]) {
-  return NULL;
+  uintptr_t *sp = ustack.end;
+  *(-- sp) = (uintptr_t)envp;
+  *(-- sp) = (uintptr_t)argv;
+  *(-- sp) = 0;
+  *(-- sp) = 0;
+
+  _RegSet *r = (_RegSet*)sp - 1;
+  for (int i = 0; i < sizeof(_RegSet) / sizeof(uintptr_t); i ++) {
+    ((uintptr_t*)r)[i] = 0;
+  }
+  r->eip = (uintptr_t)entry;
+  r->cs = KSEL(SEG_KCODE);
+  r->eflags = FL_IF | 0x2;
+  return r;
 }
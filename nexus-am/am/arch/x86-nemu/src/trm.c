@@ -5,6 +5,7 @@
 #define HAS_SERIAL
 
 #define SERIAL_PORT 0x3f8
+#define SERIAL_DMA_PORT 0x98
 
 extern char _heap_start;
 extern char _heap_end;
@@ -34,6 +35,35 @@ void _putc(char ch) {
 #endif
 }
 
+// The serial DMA takes physical addresses. With paging, the string may be
+// in user pages, so it is sent through a buffer in the kernel, which is
+// identity mapped.
+static char dma_buf[256];
+
+static void serial_dma(const char *s, size_t n) {
+  outl(SERIAL_DMA_PORT, (uint32_t)s);
+  outl(SERIAL_DMA_PORT + 4, n);
+}
+
+void _puts(const char *s, size_t n) {
+#ifdef HAS_SERIAL
+  if ((get_cr0() & CR0_PG) == 0) {
+    serial_dma(s, n);
+    return;
+  }
+
+  while (n > 0) {
+    size_t len = (n < sizeof(dma_buf) ? n : sizeof(dma_buf));
+    for (size_t i = 0; i < len; i ++) {
+      dma_buf[i] = s[i];
+    }
+    serial_dma(dma_buf, len);
+    s += len;
+    n -= len;
+  }
+#endif
+}
+
 void _halt(int code) {
   asm volatile(".byte 0xd6" : :"a"(code));
 
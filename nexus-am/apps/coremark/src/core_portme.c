@@ -38,6 +38,9 @@
 
 /** Define Host specific (POSIX), or target specific global time variables. */
 unsigned long start_time_val, stop_time_val;
+/* Guest-side counters of the timed portion, see portable_fini */
+static _PerfCnt start_perf, stop_perf;
+static uint64_t start_tsc, stop_tsc;
 
 /* Function : start_time
 	This function will be called right before starting the timed portion of the benchmark.
@@ -47,6 +50,8 @@ unsigned long start_time_val, stop_time_val;
 */
 void start_time(void) {
   start_time_val = _uptime();
+  _perf_read(&start_perf);
+  start_tsc = _rdtsc();
 }
 /* Function : stop_time
 	This function will be called right after ending the timed portion of the benchmark.
@@ -55,6 +60,8 @@ void start_time(void) {
 	or other system parameters - e.g. reading the current value of cpu cycles counter.
 */
 void stop_time(void) {
+  stop_tsc = _rdtsc();
+  _perf_read(&stop_perf);
   stop_time_val = _uptime();
 }
 /* Function : get_time
@@ -102,6 +109,20 @@ void portable_init(core_portable *p, int *argc, char *argv[])
 void portable_fini(core_portable *p)
 {
 	p->portable_id=0;
+
+	unsigned int kinstr = (stop_perf.instr - start_perf.instr) >> 10;
+	unsigned int kcycle = (stop_tsc - start_tsc) >> 10;
+	if (kinstr == 0) return; /* no counters on this platform */
+	ee_printf("Instructions     : %dK (%d per iteration)\n", kinstr,
+			kinstr / ITERATIONS * 1024 + kinstr % ITERATIONS * 1024 / ITERATIONS);
+	ee_printf("Loads/Stores     : %dK/%dK\n", (unsigned int)((stop_perf.load - start_perf.load) >> 10),
+			(unsigned int)((stop_perf.store - start_perf.store) >> 10));
+	ee_printf("Taken branches   : %dK\n", (unsigned int)((stop_perf.branch - start_perf.branch) >> 10));
+	if (kcycle >= 100) {
+		unsigned int ipc = kinstr / (kcycle / 100);
+		/* the TSC follows the host clock, so this depends on the host */
+		ee_printf("IPC (host TSC)   : %d.%d%d (host-dependent)\n", ipc / 100, ipc / 10 % 10, ipc % 10);
+	}
 }
 
 
@@ -1,9 +1,11 @@
 #include <am.h>
 
 void print(const char *s) {
-  for (; *s; s ++) {
-    _putc(*s);
+  size_t n = 0;
+  while (s[n]) {
+    n ++;
   }
+  _puts(s, n);
 }
 int main() {
   for (int i = 0; i < 10; i ++) {
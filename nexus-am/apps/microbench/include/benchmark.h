@@ -91,7 +91,9 @@ extern Setting *setting;
 
 typedef struct Result {
   int pass;
-  unsigned long tsc, msec;
+  unsigned long msec;
+  uint64_t tsc;
+  _PerfCnt perf;
 } Result;
 
 void prepare(Result *res);
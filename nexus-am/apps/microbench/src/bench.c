@@ -26,12 +26,40 @@ Benchmark benchmarks[] = {
 // Running a benchmark
 static void bench_prepare(Result *res) {
   res->msec = _uptime();
+  _perf_read(&res->perf);
+  res->tsc = _rdtsc();
 }
 
 static void bench_done(Result *res) {
+  res->tsc = _rdtsc() - res->tsc;
+  _PerfCnt now;
+  _perf_read(&now);
+  res->perf.instr = now.instr - res->perf.instr;
+  res->perf.load = now.load - res->perf.load;
+  res->perf.store = now.store - res->perf.store;
+  res->perf.mmio = now.mmio - res->perf.mmio;
+  res->perf.branch = now.branch - res->perf.branch;
+  res->perf.exception = now.exception - res->perf.exception;
   res->msec = _uptime() - res->msec;
 }
 
+// Counters are printed in units of 1K (1024) to stay within 32-bit arithmetic.
+// Instructions per TSC cycle are printed as well, but the TSC follows the
+// host clock, so that figure depends on the host unlike the counters.
+static void print_perf(Result *res) {
+  _PerfCnt *p = &res->perf;
+  if (p->instr == 0) return; // no counters on this platform
+
+  unsigned int kinstr = p->instr >> 10, kcycle = res->tsc >> 10;
+  printk("  instrs: %dK, loads: %dK, stores: %dK, branches: %dK, exceptions: %d\n",
+      kinstr, (unsigned int)(p->load >> 10), (unsigned int)(p->store >> 10),
+      (unsigned int)(p->branch >> 10), (unsigned int)p->exception);
+  if (kcycle >= 100) {
+    unsigned int ipc = kinstr / (kcycle / 100);
+    printk("  instrs per host TSC cycle (host-dependent): %d.%d%d\n", ipc / 100, ipc / 10 % 10, ipc % 10);
+  }
+}
+
 static const char *bench_check(Benchmark *bench) {
   unsigned long freesp = (unsigned long)_heap.end - (unsigned long)_heap.start;
   if (freesp < setting->mlim) {
@@ -71,12 +99,16 @@ int main() {
     } else {
       unsigned long msec = ULONG_MAX;
       int succ = 1;
+      Result best = { 0 };
       for (int i = 0; i < REPEAT; i ++) {
         Result res;
         run_once(bench, &res);
         printk(res.pass ? "*" : "X");
         succ &= res.pass;
-        if (res.msec < msec) msec = res.msec;
+        if (res.msec < msec) {
+          msec = res.msec;
+          best = res;
+        }
       }
 
       if (succ) printk(" Passed.");
@@ -90,6 +122,7 @@ int main() {
       if (SETTING != 0) {
         printk("  min time: %d ms [%d]\n", (unsigned int)msec, (unsigned int)cur);
       }
+      print_perf(&best);
 
       bench_score += cur;
     }
@@ -0,0 +1,49 @@
+#include <am.h>
+#include <klib.h>
+
+#define N 100000
+
+static volatile intptr_t lk = 0;
+static volatile int nr_done = 0;
+static volatile int cnt_spin = 0, cnt_lock = 0;
+
+static void spin_lock() {
+  while (_atomic_xchg(&lk, 1));
+}
+
+static void spin_unlock() {
+  _atomic_xchg(&lk, 0);
+}
+
+static void mp_main() {
+  for (int i = 0; i < N; i ++) {
+    spin_lock();
+    cnt_spin ++;
+    spin_unlock();
+
+    asm volatile("lock; incl %0" : "+m"(cnt_lock));
+  }
+
+  spin_lock();
+  printf("CPU #%d finished\n", _cpu());
+  nr_done ++;
+  spin_unlock();
+
+  if (_cpu() == 0) {
+    while (nr_done < _NR_CPU) ;
+    _barrier();
+    int expected = N * _NR_CPU;
+    printf("%d CPUs: cnt_spin = %d, cnt_lock = %d, expected %d\n",
+        _NR_CPU, cnt_spin, cnt_lock, expected);
+    assert(cnt_spin == expected);
+    assert(cnt_lock == expected);
+  }
+  else {
+    while (1);
+  }
+}
+
+int main() {
+  _mpe_init(mp_main);
+  return 0;
+}